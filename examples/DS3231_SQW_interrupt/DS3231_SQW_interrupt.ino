@@ -62,8 +62,9 @@ void loop () {
   if (interruptFlag) {
     interruptFlag = false;
     DateTime now = rtc.now();
+    char day[DS3231_DAY_SIZE];
     Serial.printf("%04d/%02d/%02d (%s) %02d:%02d:%02d\n",
-      now.tm_year+2000, now.tm_mon, now.tm_mday, daysOfTheWeek[now.tm_wday],
+      now.tm_year+2000, now.tm_mon, now.tm_mday, DS3231::dayOfTheWeek(now.tm_wday, day),
       now.tm_hour, now.tm_min, now.tm_sec
     );
   }
@@ -40,6 +40,7 @@ void setup () {
 
   if (rtc.isAlarmArmed(1)) {
     DateTime dt{0};
+    char day[DS3231_DAY_SIZE];
 
     DS3231_ALARM1_t mode = rtc.getAlarm1Status(&dt);
     switch (mode) {
@@ -61,7 +62,7 @@ void setup () {
         break;
       case DS3231_ALARM1_ON_WEEKDAY:
         Serial.printf("Alarm1: armed, Mode: On WeekDay, %s %02d:%02d:%02d\n", 
-          daysOfTheWeek[dt.tm_wday], dt.tm_hour, dt.tm_min, dt.tm_sec);
+          DS3231::dayOfTheWeek(dt.tm_wday, day), dt.tm_hour, dt.tm_min, dt.tm_sec);
         break;
     }
   }
@@ -76,8 +77,9 @@ void loop () {
   static uint8_t count = 0;
 
   DateTime now = rtc.now();
+  char day[DS3231_DAY_SIZE];
   Serial.printf("%04d/%02d/%02d (%s) %02d:%02d:%02d ",
-    now.tm_year+2000, now.tm_mon, now.tm_mday, daysOfTheWeek[now.tm_wday],
+    now.tm_year+2000, now.tm_mon, now.tm_mday, DS3231::dayOfTheWeek(now.tm_wday, day),
     now.tm_hour, now.tm_min, now.tm_sec
   );
   
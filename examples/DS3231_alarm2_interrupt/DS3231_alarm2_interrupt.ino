@@ -54,6 +54,7 @@ void setup () {
 
   if (rtc.isAlarmArmed(2)) {
     DateTime dt{0};
+    char day[DS3231_DAY_SIZE];
 
     DS3231_ALARM2_t mode = rtc.getAlarm2Status(&dt);
     switch (mode) {
@@ -72,7 +73,7 @@ void setup () {
         break;
       case DS3231_ALARM2_ON_WEEKDAY:
         Serial.printf("Alarm2: armed, Mode: On WeekDay, %s %02d:%02d:00\n", 
-          daysOfTheWeek[dt.tm_wday], dt.tm_hour, dt.tm_min);
+          DS3231::dayOfTheWeek(dt.tm_wday, day), dt.tm_hour, dt.tm_min);
         break;
     }
   }
@@ -97,8 +98,9 @@ void loop () {
   static uint8_t count = 0;
 
   DateTime now = rtc.now();
+  char day[DS3231_DAY_SIZE];
   Serial.printf("%04d/%02d/%02d (%s) %02d:%02d:%02d ",
-    now.tm_year+2000, now.tm_mon, now.tm_mday, daysOfTheWeek[now.tm_wday],
+    now.tm_year+2000, now.tm_mon, now.tm_mday, DS3231::dayOfTheWeek(now.tm_wday, day),
     now.tm_hour, now.tm_min, now.tm_sec
   );
   
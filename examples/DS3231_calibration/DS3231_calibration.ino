@@ -0,0 +1,104 @@
+// This sketch calibrates the aging offset of the DS3231 against the time of a
+// host computer. Every hour it prints "T" on the serial port and the host
+// replies with its Unix time, e.g. "1712139630.250000", with a script such as:
+//
+//   import serial, time
+//   port = serial.Serial("/dev/ttyUSB0", 115200)
+//   while True:
+//       if port.readline().strip() == b"T":
+//           port.write(b"%.6f\n" % time.time())
+//
+// The calibration state is saved in EEPROM, so the calibration continues
+// after a reset instead of starting from scratch.
+
+#include <DS3231.h>
+#include <DS3231Calibration.h>
+#include <EEPROM.h>
+
+#define STATE_ADDRESS 0
+#define STATE_MAGIC   0x3231
+
+class SerialReference : public DS3231Reference
+{
+public:
+  bool read(uint32_t *epoch, uint32_t *usec) override {
+    while (Serial.available())
+      Serial.read();
+    Serial.println("T");
+
+    char line[24];
+    Serial.setTimeout(100);
+    size_t len = Serial.readBytesUntil('\n', line, sizeof(line) - 1);
+    if (len == 0)
+      return false;
+    line[len] = '\0';
+
+    char *fraction;
+    uint32_t seconds = strtoul(line, &fraction, 10);
+    *usec = (*fraction == '.') ? strtoul(fraction + 1, nullptr, 10) : 0;
+    *epoch = seconds - DS3231_UNIX_OFFSET;
+    return true;
+  }
+};
+
+DS3231 rtc;
+SerialReference reference;
+DS3231Calibration calibration;
+
+void save() {
+  EEPROM.put(STATE_ADDRESS, (uint16_t) STATE_MAGIC);
+  EEPROM.put(STATE_ADDRESS + sizeof(uint16_t), calibration.state());
+}
+
+void setup () {
+
+  Serial.begin(115200);
+  while (!Serial);
+
+  if (! rtc.begin(&Wire)) {
+    Serial.println("Couldn't find RTC");
+    while (1) delay(10);
+  }
+
+  uint16_t magic;
+  EEPROM.get(STATE_ADDRESS, magic);
+  if (magic == STATE_MAGIC) {
+    DS3231Calibration_t state;
+    EEPROM.get(STATE_ADDRESS + sizeof(uint16_t), state);
+    calibration.begin(&rtc, &reference, &state);
+  }
+  else {
+    calibration.begin(&rtc, &reference);
+  }
+
+  Serial.print("Aging offset: ");
+  Serial.println(rtc.getAgingOffset());
+}
+
+void loop () {
+  static uint32_t lastSample = 0;
+  if (lastSample && millis() - lastSample < 3600000UL)
+    return;
+  lastSample = millis();
+
+  if (!calibration.sample()) {
+    Serial.println("No reference");
+    return;
+  }
+
+  Serial.print("offset (us): ");
+  Serial.print(calibration.offset());
+  Serial.print(", error (ppm): ");
+  Serial.print(calibration.ppm());
+  Serial.print(", intervals: ");
+  Serial.println(calibration.intervals());
+
+  // correct the aging offset once there is a day of measurements
+  if (calibration.state().w >= 24 && calibration.recommended() != rtc.getAgingOffset()) {
+    if (calibration.apply()) {
+      Serial.print("New aging offset: ");
+      Serial.println(rtc.getAgingOffset());
+    }
+  }
+  save();
+}
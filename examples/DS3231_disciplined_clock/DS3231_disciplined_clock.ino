@@ -0,0 +1,71 @@
+// This sketch demonstrates a software clock disciplined by the 1Hz SQW output, the
+// timestamps have microsecond resolution and reading them does not access the I2C bus
+
+#include <DS3231.h>
+#include <DS3231Clock.h>
+#include <time.h>
+
+#define INT_PIN PIN_PA5
+
+DS3231 rtc;
+DS3231Clock swClock;
+
+#if (defined(MEGATINYCORE) || defined(DXCORE) || defined(ATTIYNCORE))
+ISR(PORTA_PORT_vect) {
+    swClock.tick();
+    PORTA.INTFLAGS = PIN5_bm;
+}
+#else
+void interruptHandler() {
+  swClock.tick();
+}
+#endif
+
+void setup () {
+
+  Serial.begin(115200);
+  while (!Serial);
+
+  delay(3000);
+
+  if (! rtc.begin(&Wire)) {
+    Serial.println("Couldn't find RTC");
+    while (1) delay(10);
+  }
+
+  if (rtc.lostPower()) {
+    DateTime dt{0};
+    char ts[] = "2024/04/03 10:20:30";
+    rtc.getDateTime(ts, &dt);
+    rtc.adjust(dt);
+  }
+
+  swClock.begin(&rtc);  // set SQW to 1Hz
+
+#if (defined(MEGATINYCORE) || defined(DXCORE) || defined(ATTIYNCORE))
+  PORTA.DIRCLR = PIN5_bm;                                  // Set PA5 to input
+  PORTA.PIN5CTRL = PORT_PULLUPEN_bm | PORT_ISC_FALLING_gc; // Enable PULLUP and Interrupt on PA5
+#else
+  pinMode(INT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(INT_PIN), interruptHandler, FALLING);
+#endif
+
+}
+
+void loop () {
+  if (!swClock.update())   // synchronise with the RTC after the first SQW edge
+    return;
+
+  uint32_t usec;
+  uint32_t seconds = swClock.nowFast(&usec);
+  Serial.printf("%lu.%06lu\n", seconds, usec);
+
+  // check against the RTC once in a while
+  static uint32_t lastVerify = 0;
+  if (seconds - lastVerify >= 60) {
+    lastVerify = seconds;
+    Serial.printf("drift: %ld s, MCU clock error: %ld ppm\n", swClock.verify(), swClock.ppm());
+  }
+
+  delay(250);
+}
@@ -0,0 +1,129 @@
+// I2C cost of every public method of DS3231 and host CPU time of the
+// date/time conversions, printed as a JSON report on stdout. The methods
+// run against the TwoWire stand-in and DS3231Sim of extras/host on virtual
+// time, without and with the shadow registers. bench.py builds and runs it
+// and checks the report against budget.json.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o bench extras/bench/bench.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./bench > report.json
+#include <DS3231.h>
+#include <DS3231Sim.h>
+#include <chrono>
+
+#define CPU_ITERATIONS 2000000
+
+static DS3231Sim sim;
+static DS3231 rtc;
+static bool first = true;
+
+static uint64_t virtualMicros(void) { return sim.micros(); }
+static void virtualDelay(uint64_t usec) { sim.advance(usec); }
+static void onAlarm1(uint8_t alarm_num) { (void) alarm_num; }
+
+// Prints the bus usage of one call as "name": {...}
+#define BUS(name, call) do { \
+  Wire.resetStats(); \
+  call; \
+  const TwoWireStats_t &s = Wire.stats(); \
+  printf("%s\n      \"%s\": {\"transactions\": %u, \"bytes\": %u, \"us_100k\": %u, \"us_400k\": %u}", \
+    first ? "" : ",", name, s.transactions, s.bytes, Wire.busMicros(100000), Wire.busMicros(400000)); \
+  first = false; \
+} while (0)
+
+static void busMethods(void) {
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 4; dt.tm_mday = 3; dt.tm_hour = 10; dt.tm_min = 20; dt.tm_sec = 30;
+  dt.tm_wday = DS3231::weekDay(24, 4, 3);
+  DateTime alarm{};
+  bool busy;
+
+  BUS("begin()", rtc.begin(&Wire));
+  BUS("lostPower()", rtc.lostPower());
+  BUS("adjust()", rtc.adjust(dt));
+  BUS("adjustAligned()", rtc.adjustAligned(DS3231::toEpoch(dt), 250000, micros()));
+  BUS("now()", rtc.now());
+  BUS("epochNow()", rtc.epochNow());
+  BUS("snapshot()", rtc.snapshot());
+  BUS("readSquareWaveRate()", rtc.readSquareWaveRate());
+  BUS("setSquareWaveRate()", rtc.setSquareWaveRate(DS3231_SQW_OFF));
+  BUS("getTemperature()", rtc.getTemperature());
+  BUS("getTemperatureRaw()", rtc.getTemperatureRaw(&busy));
+  BUS("startConversion()", rtc.startConversion());
+  BUS("isConverting()", rtc.isConverting());
+  BUS("getAgingOffset()", rtc.getAgingOffset());
+  BUS("setAgingOffset()", rtc.setAgingOffset(-3));
+  BUS("setAlarm1()", rtc.setAlarm1(&dt, DS3231_ALARM1_ON_DATE));
+  BUS("setAlarm2()", rtc.setAlarm2(&dt, DS3231_ALARM2_ON_DATE));
+  BUS("getAlarm1Status()", rtc.getAlarm1Status(&alarm));
+  BUS("getAlarm2Status()", rtc.getAlarm2Status(&alarm));
+  BUS("isAlarmArmed()", rtc.isAlarmArmed(1));
+  BUS("alarmFired()", rtc.alarmFired(1));
+  BUS("clearAlarm()", rtc.clearAlarm(1));
+  BUS("disableAlarm()", rtc.disableAlarm(1));
+  rtc.onAlarm(1, onAlarm1);
+  sim.setReg(DS3231_STATUS, sim.reg(DS3231_STATUS) | 0x01);
+  BUS("service()", rtc.notify(); rtc.service());
+  BUS("enable32K()", rtc.enable32K());
+  BUS("disable32K()", rtc.disable32K());
+  BUS("is32KEnabled()", rtc.is32KEnabled());
+  BUS("enableBBSQW()", rtc.enableBBSQW());
+  BUS("disableBBSQW()", rtc.disableBBSQW());
+  BUS("commit()", rtc.beginTransaction(); rtc.setSquareWaveRate(DS3231_SQW_1HZ); rtc.disable32K(); rtc.clearAlarm(2); rtc.commit());
+  BUS("resync()", rtc.resync());
+  BUS("lastError()", rtc.lastError());
+}
+
+// Nanoseconds per call of expr, which adds its result to sink
+#define CPU(name, expr) do { \
+  auto start = std::chrono::steady_clock::now(); \
+  for (uint32_t i = 0; i < CPU_ITERATIONS; i++) { expr; } \
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CPU_ITERATIONS; \
+  printf("%s\n    \"%s\": %.1f", first ? "" : ",", name, ns); \
+  first = false; \
+} while (0)
+
+static void cpuMethods(void) {
+  volatile uint32_t sink = 0;
+  DateTime dt{};
+  DateTime a = rtc.now();
+  DS3231Snapshot snap = rtc.snapshot();
+  char buf[DS3231_FORMAT_SIZE];
+  char name[4];
+  first = true;
+
+  CPU("weekDay()", sink += DS3231::weekDay(i % 200, i % 12 + 1, i % 28 + 1));
+  CPU("dayOfTheWeek()", sink += DS3231::dayOfTheWeek(i % 7, name)[0]);
+  CPU("dayOfYear()", sink += DS3231::dayOfYear(i % 200, i % 12 + 1, i % 28 + 1));
+  CPU("fromEpoch()", DS3231::fromEpoch(i * 2053U, &dt); sink += dt.tm_mday);
+  CPU("toEpoch()", dt.tm_sec = i % 60; sink += DS3231::toEpoch(dt));
+  CPU("fromUnix()", DS3231::fromUnix(946684800U + i * 2053U, &dt); sink += dt.tm_mday);
+  CPU("toUnix()", dt.tm_sec = i % 60; sink += DS3231::toUnix(dt));
+  CPU("addSeconds()", DS3231::addSeconds(&dt, (i & 1) ? 90061 : -90061); sink += dt.tm_mday);
+  CPU("diffSeconds()", dt.tm_sec = i % 60; sink += DS3231::diffSeconds(a, dt));
+  CPU("parse()", sink += DS3231::parse("2024-04-03T10:20:30+02:00", 25, &dt) + dt.tm_hour);
+  CPU("format()", dt.tm_sec = i % 60; sink += DS3231::format(buf, sizeof(buf), dt));
+  CPU("getDateTime(ts)", sink += DS3231::getDateTime("2024/04/03 10:20:30", &dt) + dt.tm_wday);
+  CPU("getDateTime(__DATE__, __TIME__)", DS3231::getDateTime("Apr  3 2024", "10:20:30", &dt); sink += dt.tm_wday);
+  CPU("DS3231Snapshot::now()", snap.reg[0] = (i % 6) << 4 | i % 10; sink += snap.now().tm_sec);
+  CPU("DS3231Snapshot::alarm1()", sink += snap.alarm1(&dt) + dt.tm_mday);
+  CPU("DS3231Snapshot::temperatureRaw()", snap.reg[DS3231_TEMPERATURE] = i; sink += snap.temperatureRaw());
+  (void) sink;
+}
+
+int main() {
+  hostSetClock(virtualMicros, virtualDelay);
+  Wire.attach(DS3231_ADDRESS, &sim);
+
+  printf("{\n  \"bus\": {\n    \"plain\": {");
+  first = true;
+  busMethods();
+  printf("\n    },\n    \"shadow\": {");
+  first = true;
+  BUS("enableShadow()", rtc.enableShadow());
+  busMethods();
+  printf("\n    }\n  },\n  \"cpu_ns\": {");
+  cpuMethods();
+  printf("\n  }\n}\n");
+  return 0;
+}
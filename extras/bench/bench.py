@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""I2C cost and host CPU time of the DS3231 methods against the budget in
+budget.json.
+
+    python3 extras/bench/bench.py                      # check against the budget
+    python3 extras/bench/bench.py --report report.json # also keep the JSON report
+    python3 extras/bench/bench.py --update             # write the results as the new budget
+
+Builds bench.cpp with the host stand-ins of extras/host (g++, or $CXX), runs
+it and prints, for each public method, the I2C transactions, bytes and bus
+time at 100kHz/400kHz without and with the shadow registers, and the
+nanoseconds per call of the conversions. Exits with 1 when a method is over
+its budget or has none. The bus numbers are exact and the budget is the measured cost,
+the CPU times depend on the host and their budget leaves CPU_HEADROOM.
+"""
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+HERE = os.path.dirname(os.path.abspath(__file__))
+BUDGET = os.path.join(HERE, 'budget.json')
+SOURCES = ['extras/bench/bench.cpp', 'src/DS3231.cpp', 'extras/host/Arduino.cpp',
+           'extras/host/Wire.cpp', 'extras/host/DS3231Sim.cpp']
+BUS_KEYS = ('transactions', 'bytes', 'us_100k', 'us_400k')
+CPU_HEADROOM = 4    # budget of the CPU times, times the measured one
+
+
+def build(work):
+    exe = os.path.join(work, 'bench')
+    cxx = os.environ.get('CXX', 'g++')
+    subprocess.run([cxx, '-O2', '-std=gnu++11', '-Iextras/host', '-Isrc', '-o', exe] + SOURCES,
+                   check=True, cwd=ROOT)
+    return exe
+
+
+def run():
+    work = tempfile.mkdtemp(prefix='ds3231-bench-')
+    try:
+        out = subprocess.run([build(work)], check=True, capture_output=True, text=True).stdout
+    finally:
+        shutil.rmtree(work, ignore_errors=True)
+    return json.loads(out)
+
+
+def check_bus(report, budget):
+    over = False
+    print('%-22s %-6s %12s %8s %9s %9s' % ('method', 'mode', 'transactions', 'bytes', '100kHz us', '400kHz us'))
+    for mode in ('plain', 'shadow'):
+        for method, cost in report['bus'][mode].items():
+            limit = budget.get('bus', {}).get(mode, {}).get(method)
+            if limit is None:
+                status = 'no budget'
+                over = True
+            else:
+                status = ', '.join('%s over by %d' % (key, cost[key] - limit[key])
+                                   for key in BUS_KEYS if key in limit and cost[key] > limit[key]) or 'ok'
+                over |= status != 'ok'
+            print('%-22s %-6s %12d %8d %9d %9d  %s' % (
+                method, mode, cost['transactions'], cost['bytes'], cost['us_100k'], cost['us_400k'], status))
+    return over
+
+
+def check_cpu(report, budget):
+    over = False
+    print()
+    print('%-36s %8s %8s' % ('conversion', 'ns', 'budget'))
+    for name, ns in report['cpu_ns'].items():
+        limit = budget.get('cpu_ns', {}).get(name)
+        if limit is None:
+            status = 'no budget'
+            over = True
+        elif ns > limit:
+            status = 'over by %.1f' % (ns - limit)
+            over = True
+        else:
+            status = 'ok'
+        print('%-36s %8.1f %8s  %s' % (name, ns, '-' if limit is None else limit, status))
+    return over
+
+
+def write_budget(budget):
+    """budget.json with one method per line"""
+    lines = ['{', '  "bus": {']
+    for i, mode in enumerate(('plain', 'shadow')):
+        lines.append('    "%s": {' % mode)
+        methods = list(budget['bus'][mode].items())
+        for j, (method, cost) in enumerate(methods):
+            lines.append('      %s: %s%s' % (json.dumps(method), json.dumps(cost), ',' if j < len(methods) - 1 else ''))
+        lines.append('    }' + (',' if i == 0 else ''))
+    lines.append('  },')
+    lines.append('  "cpu_ns": {')
+    conversions = list(budget['cpu_ns'].items())
+    for j, (name, ns) in enumerate(conversions):
+        lines.append('    %s: %s%s' % (json.dumps(name), ns, ',' if j < len(conversions) - 1 else ''))
+    lines.append('  }')
+    lines.append('}')
+    with open(BUDGET, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--report', help='write the JSON report to this file')
+    parser.add_argument('--update', action='store_true', help='write the results to budget.json')
+    args = parser.parse_args()
+
+    with open(BUDGET) as f:
+        budget = json.load(f)
+    report = run()
+    if args.report:
+        with open(args.report, 'w') as f:
+            json.dump(report, f, indent=2)
+            f.write('\n')
+
+    over = check_bus(report, budget)
+    over |= check_cpu(report, budget)
+
+    if args.update:
+        budget = {
+            'bus': report['bus'],
+            'cpu_ns': {name: int(ns * CPU_HEADROOM + 9) // 10 * 10 for name, ns in report['cpu_ns'].items()},
+        }
+        write_budget(budget)
+    return 1 if over and not args.update else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
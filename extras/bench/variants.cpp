@@ -0,0 +1,104 @@
+// Host CPU time of the same calls on the runtime DS3231 class and on the
+// compile-time DS3231T template, printed as a JSON report on stdout. Built
+// once per variant, DS3231T with -DDS3231_BENCH_TEMPLATE. The device is a
+// plain register file and micros() a constant, so the time measured is the
+// driver and the TwoWire stand-in, not the bus or the register model.
+// variants.py builds both variants, runs them and compares their code size.
+//
+//   g++ -Os -std=gnu++11 -Iextras/host -Isrc -o variants extras/bench/variants.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp [-DDS3231_BENCH_TEMPLATE]
+//   ./variants
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0ULL
+#endif
+
+#ifdef DS3231_BENCH_TEMPLATE
+#include <DS3231T.h>
+static DS3231T<TwoWire> rtc(Wire);
+#define VARIANT "DS3231T"
+#define BEGIN() rtc.begin()
+#else
+#include <DS3231.h>
+static DS3231 rtc;
+#define VARIANT "DS3231"
+#define BEGIN() rtc.begin(&Wire)
+#endif
+
+#define ITERATIONS 100000
+#define REPEATS    7
+
+// The registers of a DS3231 without the clock running
+class RegisterFile : public TwoWireDevice
+{
+public:
+  uint8_t reg[DS3231_REGISTERS]{0};
+
+  bool onWrite(const uint8_t *data, size_t len) override {
+    _pointer = data[0];
+    for (size_t i = 1; i < len; i++)
+      reg[(_pointer++) % DS3231_REGISTERS] = data[i];
+    return true;
+  }
+  bool onRead(uint8_t *data, size_t len) override {
+    for (size_t i = 0; i < len; i++)
+      data[i] = reg[(_pointer++) % DS3231_REGISTERS];
+    return true;
+  }
+
+private:
+  uint8_t _pointer{0};
+};
+
+static RegisterFile chip;
+static volatile uint32_t sink;
+static bool first = true;
+
+static uint64_t constantMicros(void) { return 0; }
+static void noDelay(uint64_t usec) { (void) usec; }
+
+// Prints the nanoseconds and cycles per call as "name": {...}, the best of
+// REPEATS runs of ITERATIONS calls
+#define CPU(name, expr) do { \
+  double best_ns = 1e30, best_cycles = 1e30; \
+  for (uint8_t r = 0; r < REPEATS; r++) { \
+    auto start = std::chrono::steady_clock::now(); \
+    uint64_t c0 = CYCLES(); \
+    for (uint32_t i = 0; i < ITERATIONS; i++) \
+      sink = sink + static_cast<uint32_t>(expr); \
+    uint64_t c1 = CYCLES(); \
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count(); \
+    if (ns < best_ns) best_ns = ns; \
+    if (c1 - c0 < best_cycles) best_cycles = c1 - c0; \
+  } \
+  printf("%s\n    \"%s\": {\"ns\": %.1f, \"cycles\": %.0f}", first ? "" : ",", name, \
+    best_ns / ITERATIONS, best_cycles / ITERATIONS); \
+  first = false; \
+} while (0)
+
+int main() {
+  hostSetClock(constantMicros, noDelay);
+  Wire.attach(DS3231_ADDRESS, &chip);
+  BEGIN();
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 4; dt.tm_mday = 3; dt.tm_hour = 10; dt.tm_min = 20; dt.tm_sec = 30;
+  dt.tm_wday = DS3231::weekDay(24, 4, 3);
+  rtc.adjust(dt);
+
+  printf("{\n  \"variant\": \"%s\",\n  \"cpu\": {", VARIANT);
+  CPU("now()", rtc.now().tm_sec);
+  CPU("epochNow()", rtc.epochNow());
+  CPU("adjust()", (rtc.adjust(dt), 0));
+  CPU("snapshot()", rtc.snapshot().reg[0]);
+  CPU("getTemperatureRaw()", rtc.getTemperatureRaw());
+  CPU("setAlarm1()", (rtc.setAlarm1(&dt, DS3231_ALARM1_ON_DATE), 0));
+  CPU("alarmFired()", rtc.alarmFired(1));
+  CPU("clearAlarm()", (rtc.clearAlarm(1), 0));
+  CPU("setSquareWaveRate()", (rtc.setSquareWaveRate(DS3231_SQW_1HZ), 0));
+  printf("\n  }\n}\n");
+  hostSetClock(nullptr, nullptr);
+  return 0;
+}
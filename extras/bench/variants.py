@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Code size and host CPU time of the runtime DS3231 class against the
+compile-time DS3231T template.
+
+    python3 extras/bench/variants.py                      # print the comparison
+    python3 extras/bench/variants.py --report report.json # also keep the JSON report
+
+Builds variants.cpp twice with the host stand-ins of extras/host (g++, or
+$CXX, -Os with the unused sections removed), once on DS3231 and once on
+DS3231T<TwoWire>, runs both and prints the text/data/bss of each program
+(size, or $SIZE) and, for each method, the nanoseconds and the TSC cycles
+per call. Both programs link the same stand-ins, so the size difference is
+the difference of the drivers on the host compiler. The flash and SRAM on
+the AVR target are reported by extras/size/size_report.py for the DS3231
+and DS3231_template examples.
+"""
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+SOURCES = ['extras/bench/variants.cpp', 'src/DS3231.cpp', 'extras/host/Arduino.cpp',
+           'extras/host/Wire.cpp']
+FLAGS = ['-Os', '-std=gnu++11', '-ffunction-sections', '-fdata-sections', '-Wl,--gc-sections',
+         '-Iextras/host', '-Isrc']
+VARIANTS = (('DS3231', []), ('DS3231T', ['-DDS3231_BENCH_TEMPLATE']))
+
+
+def build(work, name, defines):
+    exe = os.path.join(work, name)
+    cxx = os.environ.get('CXX', 'g++')
+    subprocess.run([cxx] + FLAGS + defines + ['-o', exe] + SOURCES, check=True, cwd=ROOT)
+    return exe
+
+
+def size(exe):
+    out = subprocess.run([os.environ.get('SIZE', 'size'), exe], check=True, capture_output=True, text=True).stdout
+    text, data, bss = out.splitlines()[1].split()[:3]
+    return {'text': int(text), 'data': int(data), 'bss': int(bss)}
+
+
+def run():
+    report = {}
+    work = tempfile.mkdtemp(prefix='ds3231-variants-')
+    try:
+        for name, defines in VARIANTS:
+            exe = build(work, name, defines)
+            result = json.loads(subprocess.run([exe], check=True, capture_output=True, text=True).stdout)
+            report[name] = {'size': size(exe), 'cpu': result['cpu']}
+    finally:
+        shutil.rmtree(work, ignore_errors=True)
+    return report
+
+
+def show(report):
+    base, spec = (report[name] for name, _ in VARIANTS)
+    print('%-22s %10s %10s %10s' % ('size (bytes)', 'DS3231', 'DS3231T', 'change'))
+    for key in ('text', 'data', 'bss'):
+        print('%-22s %10d %10d %+10d' % (key, base['size'][key], spec['size'][key],
+                                         spec['size'][key] - base['size'][key]))
+    print()
+    print('%-22s %10s %10s %10s %10s %8s' % ('method', 'DS3231 ns', 'cycles', 'DS3231T ns', 'cycles', 'change'))
+    for method, cost in base['cpu'].items():
+        other = spec['cpu'][method]
+        print('%-22s %10.1f %10.0f %10.1f %10.0f %+7.0f%%' % (
+            method, cost['ns'], cost['cycles'], other['ns'], other['cycles'],
+            100.0 * (other['ns'] - cost['ns']) / cost['ns']))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--report', help='write the JSON report to this file')
+    args = parser.parse_args()
+
+    report = run()
+    show(report)
+    if args.report:
+        with open(args.report, 'w') as f:
+            json.dump(report, f, indent=2)
+            f.write('\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,181 @@
+// ds3231d - publishes the time of a DS3231 on a Linux i2c-dev bus in POSIX
+// shared memory, see extras/host/DS3231Shm.h for the readers.
+//
+// The chip is read once per second: on the falling edge of the 1Hz SQW
+// output when it is wired to a GPIO (-g), otherwise by polling the registers
+// every few milliseconds (-i) until the second changes. Once a boundary has
+// been seen, the daemon sleeps until DS3231D_GUARD_MS before the next one and
+// only polls from there, a few reads per second.
+//
+//   ds3231d [-d /dev/i2c-1] [-n /ds3231] [-g /sys/class/gpio/gpio17] [-i 5]
+//
+// Build:
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o ds3231d extras/ds3231d/ds3231d.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/LinuxWire.cpp -lrt
+#include <DS3231.h>
+#include <LinuxWire.h>
+#include <DS3231Shm.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <getopt.h>
+
+#define DS3231D_GUARD_MS  3   // polling starts this long before the predicted second boundary
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) {
+  running = 0;
+}
+
+static uint64_t monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void publish(DS3231ShmWriter &shm, const DS3231Snapshot &snap, uint64_t edge_ns, uint32_t error_ns, bool edge) {
+  static uint32_t updates = 0;
+  DateTime dt = snap.now();
+  DS3231ShmRecord_t record{};
+  record.epoch = DS3231::toEpoch(dt);
+  record.updates = ++updates;
+  record.edge_ns = edge_ns;
+  record.error_ns = error_ns;
+  record.temperature = snap.temperatureRaw();
+  record.control = snap.control();
+  record.status = snap.status();
+  record.year = dt.tm_year;
+  record.month = dt.tm_mon;
+  record.day = dt.tm_mday;
+  record.hour = dt.tm_hour;
+  record.minute = dt.tm_min;
+  record.second = dt.tm_sec;
+  record.wday = dt.tm_wday;
+  record.edge = edge;
+  shm.publish(record);
+}
+
+// Configure the GPIO (sysfs) for the falling edge of SQW and open its value
+static int open_gpio(const char *gpio) {
+  char path[128];
+  snprintf(path, sizeof(path), "%s/edge", gpio);
+  int fd = open(path, O_WRONLY);
+  if (fd >= 0) {
+    if (write(fd, "falling", 7) != 7)
+      fprintf(stderr, "ds3231d: cannot set %s\n", path);
+    close(fd);
+  }
+  snprintf(path, sizeof(path), "%s/value", gpio);
+  return open(path, O_RDONLY);
+}
+
+static void run_edge(DS3231 &rtc, DS3231ShmWriter &shm, int gpio) {
+  char value[4];
+  rtc.setSquareWaveRate(DS3231_SQW_1HZ);
+  struct pollfd pfd = {gpio, POLLPRI | POLLERR, 0};
+  lseek(gpio, 0, SEEK_SET);
+  if (read(gpio, value, sizeof(value)) < 0)
+    return;
+
+  while (running) {
+    if (poll(&pfd, 1, 1500) <= 0)
+      continue;  // timeout or signal
+    uint64_t edge_ns = monotonic_ns();
+    lseek(gpio, 0, SEEK_SET);
+    if (read(gpio, value, sizeof(value)) < 0)
+      break;
+    publish(shm, rtc.snapshot(), edge_ns, 0, true);
+  }
+}
+
+static void sleep_until(uint64_t ns) {
+  struct timespec ts;
+  ts.tv_sec = ns / 1000000000ULL;
+  ts.tv_nsec = ns % 1000000000ULL;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR && running);
+}
+
+// Polls every interval_ms until the seconds change, then sleeps until
+// DS3231D_GUARD_MS before the next boundary (one second after the last one)
+// and polls again from there. The registers published are those of the
+// read that saw the seconds change.
+static void run_poll(DS3231 &rtc, DS3231ShmWriter &shm, uint32_t interval_ms) {
+  uint64_t last_ns = monotonic_ns();
+  DS3231Snapshot last = rtc.snapshot();
+  uint64_t next_ns = 0;  // predicted second boundary, 0 until one is seen
+
+  while (running) {
+    if (next_ns && next_ns - DS3231D_GUARD_MS * 1000000ULL > monotonic_ns())
+      sleep_until(next_ns - DS3231D_GUARD_MS * 1000000ULL);
+    else
+      usleep(interval_ms * 1000);
+    uint64_t start_ns = monotonic_ns();
+    DS3231Snapshot snap = rtc.snapshot();
+    uint64_t end_ns = monotonic_ns();
+    if (rtc.lastError() != DS3231_OK) {
+      next_ns = 0;
+      continue;
+    }
+    if (snap.reg[DS3231_TIME] != last.reg[DS3231_TIME]) {
+      // the second changed between the start of the previous read and the end of this one
+      uint64_t edge_ns = (last_ns + end_ns) / 2;
+      publish(shm, snap, edge_ns, static_cast<uint32_t>((end_ns - last_ns) / 2), false);
+      next_ns = edge_ns + 1000000000ULL;
+    }
+    last = snap;
+    last_ns = start_ns;
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *device = "/dev/i2c-1";
+  const char *name = DS3231_SHM_NAME;
+  const char *gpio_path = nullptr;
+  uint32_t interval_ms = 5;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "d:n:g:i:")) != -1) {
+    switch (opt) {
+      case 'd': device = optarg; break;
+      case 'n': name = optarg; break;
+      case 'g': gpio_path = optarg; break;
+      case 'i': interval_ms = strtoul(optarg, nullptr, 10); break;
+      default:
+        fprintf(stderr, "usage: %s [-d i2c device] [-n shm name] [-g gpio sysfs dir] [-i poll interval ms]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  LinuxWire bus;
+  DS3231 rtc;
+  if (!bus.open(device) || !rtc.begin(&bus)) {
+    fprintf(stderr, "ds3231d: no DS3231 on %s: %s\n", device, strerror(errno));
+    return 1;
+  }
+
+  DS3231ShmWriter shm;
+  if (!shm.open(name)) {
+    fprintf(stderr, "ds3231d: cannot create %s: %s\n", name, strerror(errno));
+    return 1;
+  }
+
+  signal(SIGINT, stop);
+  signal(SIGTERM, stop);
+
+  if (gpio_path) {
+    int gpio = open_gpio(gpio_path);
+    if (gpio < 0) {
+      fprintf(stderr, "ds3231d: cannot open %s: %s\n", gpio_path, strerror(errno));
+      return 1;
+    }
+    run_edge(rtc, shm, gpio);
+    close(gpio);
+  }
+  else {
+    run_poll(rtc, shm, interval_ms ? interval_ms : 1);
+  }
+
+  shm.close(true);
+  return 0;
+}
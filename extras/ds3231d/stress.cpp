@@ -0,0 +1,135 @@
+// Stress test and benchmark of the seqlock of DS3231Shm.h. One writer
+// publishes records as fast as it can while reader threads copy them; every
+// field of a record is derived from its update counter, so a torn copy (a
+// mix of two records) shows up as an inconsistent record. Each reader also
+// checks that the updates it sees never go backwards. The readers are then
+// timed without the writer and under a writer publishing continuously.
+//
+//   g++ -O2 -std=gnu++11 -pthread -Iextras/host -o stress extras/ds3231d/stress.cpp -lrt
+//   ./stress [readers] [seconds]
+#include <DS3231Shm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static std::atomic<bool> running{false};
+static std::atomic<bool> writing{false};
+
+typedef struct {
+  uint64_t reads;
+  uint64_t misses;    // read() false after DS3231_SHM_RETRIES attempts
+  uint64_t torn;
+  uint64_t backwards;
+} Counters_t;
+
+static DS3231ShmRecord_t record(uint32_t n) {
+  DS3231ShmRecord_t r{};
+  r.updates = n;
+  r.epoch = n * 7;
+  r.edge_ns = n * 1000000007ULL;
+  r.error_ns = n ^ 0xA5A5A5A5UL;
+  r.temperature = static_cast<int16_t>(n * 3);
+  r.control = n;
+  r.status = ~n;
+  r.year = n >> 8;
+  r.month = n >> 16;
+  r.day = n >> 24;
+  r.hour = n + 1;
+  r.minute = n + 2;
+  r.second = n + 3;
+  r.wday = n + 4;
+  r.edge = n & 1;
+  return r;
+}
+
+static bool consistent(const DS3231ShmRecord_t &r) {
+  DS3231ShmRecord_t expect = record(r.updates);
+  return memcmp(&r, &expect, sizeof(r)) == 0;
+}
+
+static void writer(const char *name, uint32_t *published) {
+  DS3231ShmWriter shm;
+  shm.open(name);
+  uint32_t n = *published;
+  while (running) {
+    if (writing)
+      shm.publish(record(++n));
+    else
+      std::this_thread::yield();
+  }
+  *published = n;
+}
+
+static void reader(const char *name, Counters_t *c) {
+  DS3231ShmReader shm;
+  shm.open(name);
+  DS3231ShmRecord_t r;
+  uint32_t last = 0;
+  while (running) {
+    if (!shm.read(&r)) {
+      c->misses++;
+      continue;
+    }
+    c->reads++;
+    if (!consistent(r))
+      c->torn++;
+    else if (r.updates < last)
+      c->backwards++;
+    last = r.updates;
+  }
+}
+
+// Runs the readers for the given time, the writer publishing or not
+static Counters_t run(const char *name, unsigned readers, double seconds, bool publish, uint32_t *published) {
+  std::vector<Counters_t> counters(readers, Counters_t{});
+  std::vector<std::thread> threads;
+  running = true;
+  writing = publish;
+  threads.emplace_back(writer, name, published);
+  for (unsigned i = 0; i < readers; i++)
+    threads.emplace_back(reader, name, &counters[i]);
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  running = false;
+  for (auto &t : threads)
+    t.join();
+
+  Counters_t total{};
+  for (const Counters_t &c : counters) {
+    total.reads += c.reads;
+    total.misses += c.misses;
+    total.torn += c.torn;
+    total.backwards += c.backwards;
+  }
+  return total;
+}
+
+int main(int argc, char **argv) {
+  unsigned readers = (argc > 1) ? atoi(argv[1]) : 4;
+  double seconds = (argc > 2) ? atof(argv[2]) : 2.0;
+  char name[32];
+  snprintf(name, sizeof(name), "/ds3231-stress-%d", static_cast<int>(getpid()));
+
+  DS3231ShmWriter shm;
+  if (!shm.open(name)) {
+    printf("cannot create %s\n", name);
+    return 1;
+  }
+  uint32_t published = 1;
+  shm.publish(record(published));
+
+  Counters_t idle = run(name, readers, seconds / 2, false, &published);
+  uint32_t before = published;
+  Counters_t busy = run(name, readers, seconds, true, &published);
+  shm.close(true);
+
+  printf("%u readers, writer idle:  %.1f M reads/s per reader\n", readers, idle.reads / (seconds / 2) / readers / 1e6);
+  printf("%u readers, writer busy:  %.1f M reads/s per reader, %.1f M records/s published, %llu misses\n", readers,
+    busy.reads / seconds / readers / 1e6, (published - before) / seconds / 1e6, (unsigned long long) busy.misses);
+  uint64_t torn = idle.torn + busy.torn;
+  uint64_t backwards = idle.backwards + busy.backwards;
+  printf("%llu reads, %llu torn, %llu out of order\n", (unsigned long long) (idle.reads + busy.reads),
+    (unsigned long long) torn, (unsigned long long) backwards);
+  return (torn || backwards || busy.reads == 0) ? 1 : 0;
+}
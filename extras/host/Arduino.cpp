@@ -0,0 +1,44 @@
+#include "Arduino.h"
+#include <time.h>
+
+static HostClock_t _clock = nullptr;
+static HostDelay_t _delay = nullptr;
+
+static uint64_t monotonic_micros(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void monotonic_delay(uint64_t usec) {
+  struct timespec ts;
+  ts.tv_sec = usec / 1000000ULL;
+  ts.tv_nsec = (usec % 1000000ULL) * 1000;
+  nanosleep(&ts, nullptr);
+}
+
+void hostSetClock(HostClock_t clock, HostDelay_t delay) {
+  _clock = clock;
+  _delay = delay;
+}
+
+void hostElapse(uint64_t usec) {
+  if (_delay)
+    _delay(usec);
+}
+
+uint32_t micros(void) {
+  return static_cast<uint32_t>(_clock ? _clock() : monotonic_micros());
+}
+
+uint32_t millis(void) {
+  return static_cast<uint32_t>((_clock ? _clock() : monotonic_micros()) / 1000);
+}
+
+void delay(unsigned long ms) {
+  (_delay ? _delay : monotonic_delay)((uint64_t) ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  (_delay ? _delay : monotonic_delay)(us);
+}
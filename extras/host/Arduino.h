@@ -0,0 +1,47 @@
+#ifndef __HOST_ARDUINO_H__
+#define __HOST_ARDUINO_H__
+// Minimal stand-in of the Arduino core for building the library on a host (Linux/x86)
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// 32 bits as on the targets, so the host build wraps after 71 minutes of micros()
+uint32_t micros(void);
+uint32_t millis(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+#define LOW          0
+#define HIGH         1
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+
+// GPIOs are not connected on the host, the pins read HIGH (pulled up)
+inline void pinMode(uint8_t pin, uint8_t mode) { (void) pin; (void) mode; }
+inline void digitalWrite(uint8_t pin, uint8_t val) { (void) pin; (void) val; }
+inline int digitalRead(uint8_t pin) { (void) pin; return HIGH; }
+
+// Flash and RAM share the address space on the host
+#define PROGMEM
+#define pgm_read_byte(addr)  (*reinterpret_cast<const uint8_t *>(addr))
+#define pgm_read_word(addr)  (*reinterpret_cast<const uint16_t *>(addr))
+#define strcpy_P(dst, src)   strcpy((dst), (src))
+#define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+
+// There is no interrupt on the host, ISRs are called from the simulation
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+// Replace the time source of micros()/millis()/delay(), e.g. with the
+// virtual time of DS3231Sim. nullptr restores the host monotonic clock.
+typedef uint64_t (*HostClock_t)(void);
+typedef void (*HostDelay_t)(uint64_t usec);
+void hostSetClock(HostClock_t clock, HostDelay_t delay);
+
+// Time taken by a bus transfer, only passes on a virtual time source
+void hostElapse(uint64_t usec);
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef __HOST_DS3231_SHM_H__
+#define __HOST_DS3231_SHM_H__
+// Time published by the ds3231d daemon in POSIX shared memory (Linux). A
+// single writer updates the record under a seqlock, any number of readers
+// copy it without locks and without system calls, so the processes that
+// need the time do not share the I2C bus.
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <atomic>
+
+#define DS3231_SHM_NAME     "/ds3231"
+#define DS3231_SHM_MAGIC    0x32335344UL  // "DS32" in memory (little endian)
+#define DS3231_SHM_VERSION  1
+#define DS3231_SHM_RETRIES  64            // attempts of read() while the record is being written
+
+// One sample of the DS3231, taken at a second boundary
+typedef struct {
+  uint32_t epoch;          // seconds since 2000/01/01 00:00:00 that started at edge_ns
+  uint32_t updates;        // number of records published
+  uint64_t edge_ns;        // CLOCK_MONOTONIC of the second boundary
+  uint32_t error_ns;       // uncertainty of edge_ns
+  int16_t temperature;     // signed Q8.2 (quarter degrees)
+  uint8_t control;         // CONTROL register
+  uint8_t status;          // STATUS register (OSF, EN32kHz, BSY, A2F, A1F)
+  uint8_t year;            // years since 2000
+  uint8_t month;           // 1 - 12
+  uint8_t day;             // 1 - 31
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  uint8_t wday;            // 0 (Sunday) - 6
+  uint8_t edge;            // 1 when edge_ns is from the SQW interrupt, 0 when found by polling
+} DS3231ShmRecord_t;
+
+#define DS3231_SHM_WORDS ((sizeof(DS3231ShmRecord_t) + 3) / 4)
+
+// Layout of the segment, the record is copied word by word with atomic
+// accesses so that a torn copy is detected instead of being undefined
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint32_t> seq;    // odd while the record is being written
+  std::atomic<uint32_t> words[DS3231_SHM_WORDS];
+} DS3231ShmSegment_t;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the seqlock needs lock-free 32-bit atomics");
+
+class DS3231ShmWriter
+{
+public:
+  ~DS3231ShmWriter() { close(); }
+
+  bool open(const char *name = DS3231_SHM_NAME) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+      return false;
+    bool sized = ftruncate(fd, sizeof(DS3231ShmSegment_t)) == 0;
+    void *p = sized ? mmap(nullptr, sizeof(DS3231ShmSegment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (p == MAP_FAILED)
+      return false;
+    _seg = static_cast<DS3231ShmSegment_t *>(p);
+    _name = name;
+    _seg->version = DS3231_SHM_VERSION;
+    _seg->magic = DS3231_SHM_MAGIC;
+    return true;
+  }
+
+  void close(bool unlink = false) {
+    if (_seg)
+      munmap(_seg, sizeof(DS3231ShmSegment_t));
+    if (_seg && unlink)
+      shm_unlink(_name);
+    _seg = nullptr;
+  }
+
+  void publish(const DS3231ShmRecord_t &record) {
+    uint32_t words[DS3231_SHM_WORDS]{0};
+    memcpy(words, &record, sizeof(record));
+    uint32_t seq = _seg->seq.load(std::memory_order_relaxed);
+    _seg->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < DS3231_SHM_WORDS; i++)
+      _seg->words[i].store(words[i], std::memory_order_relaxed);
+    _seg->seq.store(seq + 2, std::memory_order_release);
+  }
+
+private:
+  DS3231ShmSegment_t *_seg{nullptr};
+  const char *_name{DS3231_SHM_NAME};
+};
+
+class DS3231ShmReader
+{
+public:
+  ~DS3231ShmReader() { close(); }
+
+  bool open(const char *name = DS3231_SHM_NAME) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+      return false;
+    void *p = mmap(nullptr, sizeof(DS3231ShmSegment_t), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+      return false;
+    _seg = static_cast<const DS3231ShmSegment_t *>(p);
+    if (_seg->magic != DS3231_SHM_MAGIC || _seg->version != DS3231_SHM_VERSION) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close(void) {
+    if (_seg)
+      munmap(const_cast<DS3231ShmSegment_t *>(_seg), sizeof(DS3231ShmSegment_t));
+    _seg = nullptr;
+  }
+
+  // Copy the last record, false if nothing is published yet or the writer
+  // kept updating it for DS3231_SHM_RETRIES attempts. Never blocks.
+  bool read(DS3231ShmRecord_t *record) const {
+    uint32_t words[DS3231_SHM_WORDS];
+    for (uint8_t attempt = 0; attempt < DS3231_SHM_RETRIES; attempt++) {
+      uint32_t seq = _seg->seq.load(std::memory_order_acquire);
+      if (seq & 1)
+        continue;
+      for (size_t i = 0; i < DS3231_SHM_WORDS; i++)
+        words[i] = _seg->words[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_seg->seq.load(std::memory_order_relaxed) == seq) {
+        memcpy(record, words, sizeof(*record));
+        return seq != 0;
+      }
+    }
+    return false;
+  }
+
+  // Current time extrapolated from the last second boundary with
+  // CLOCK_MONOTONIC, seconds since 2000/01/01 00:00:00 and nanoseconds
+  bool now(uint32_t *epoch, uint32_t *nsec) const {
+    DS3231ShmRecord_t record;
+    if (!read(&record))
+      return false;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t elapsed = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec - record.edge_ns;
+    *epoch = record.epoch + static_cast<uint32_t>(elapsed / 1000000000ULL);
+    *nsec = static_cast<uint32_t>(elapsed % 1000000000ULL);
+    return true;
+  }
+
+private:
+  const DS3231ShmSegment_t *_seg{nullptr};
+};
+
+#endif
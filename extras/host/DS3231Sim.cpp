@@ -0,0 +1,480 @@
+#include "DS3231Sim.h"
+
+#define SIM_CONVERSION_US 125000  // typical tCONV
+#define SIM_TCXO_PERIOD   64      // seconds between automatic conversions
+
+static uint8_t bcd2bin(uint8_t val) { return val - 6 * (val >> 4); }
+static uint8_t bin2bcd(uint8_t val) { return val + 6 * (val / 10); }
+
+/**************************************************************************/
+/*!
+  @brief  Reset the registers to the power-on state: 2000/01/01 00:00:00,
+  INTCN set with SQW at 8192Hz, EN32kHz and OSF set.
+*/
+/**************************************************************************/
+void DS3231Sim::powerOn(void) {
+  memset(_reg, 0, sizeof(_reg));
+  _reg[0x03] = 0x01;  // Day, 1 = Sunday
+  _reg[0x04] = 0x01;  // Date
+  _reg[0x05] = 0x01;  // Month
+  _reg[0x0E] = 0x1C;
+  _reg[0x0F] = 0x88;
+  _pointer = 0;
+  _phase = 0;
+  _drift = 0;
+  _conversion = 0;
+  _seconds_to_tcxo = SIM_TCXO_PERIOD;
+  _convert();
+}
+
+/**************************************************************************/
+/*!
+  @brief  I2C write, the first byte sets the register pointer
+  @return True (ACK)
+*/
+/**************************************************************************/
+bool DS3231Sim::onWrite(const uint8_t *data, size_t len) {
+  _pointer = data[0] % DS3231_SIM_REGISTERS;
+  for (size_t i = 1; i < len; i++) {
+    _write(_pointer, data[i]);
+    _pointer = (_pointer + 1) % DS3231_SIM_REGISTERS;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  I2C read from the register pointer
+  @return True (ACK)
+*/
+/**************************************************************************/
+bool DS3231Sim::onRead(uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    data[i] = _reg[_pointer];
+    _pointer = (_pointer + 1) % DS3231_SIM_REGISTERS;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Move the virtual time forward
+  @param  usec real time in microseconds, the RTC runs faster or slower by
+  frequencyError()
+  @details The interrupt callback is called at each falling edge of the
+  INT/SQW pin with micros() at the time of the edge. While INTCN is set
+  and no conversion is running, the seconds without an alarm match are
+  skipped in one step, so years of virtual time take milliseconds.
+*/
+/**************************************************************************/
+void DS3231Sim::advance(uint64_t usec) {
+  _advance(usec, false);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Move the virtual time forward until INT is asserted, as an MCU
+  sleeping on the INT pin
+  @param  usec longest real time in microseconds
+  @return Microseconds elapsed, 0 when INT is already asserted
+  @details The seconds without an alarm match are skipped as by advance().
+*/
+/**************************************************************************/
+uint64_t DS3231Sim::advanceUntilInterrupt(uint64_t usec) {
+  return _advance(usec, true);
+}
+
+uint64_t DS3231Sim::_advance(uint64_t usec, bool until_int) {
+  uint64_t start = _micros;
+  uint64_t target = _micros + usec;
+  while (_micros < target && !(until_int && intLow())) {
+    double scale = 1.0 + frequencyError() * 1e-6;
+    if (_jump(target, scale))
+      continue;
+
+    // RTC time to the next edge, second or end of conversion
+    uint32_t event = 1000000UL - _phase;
+    uint32_t f = _sqw_frequency();
+    if (f > 1) {
+      uint64_t k = (uint64_t) _phase * f / 1000000UL + 1;
+      uint32_t edge = static_cast<uint32_t>((k * 1000000UL + f - 1) / f);
+      if (edge - _phase < event)
+        event = edge - _phase;
+    }
+    if (_conversion && _conversion < event)
+      event = _conversion;
+
+    uint64_t real = static_cast<uint64_t>((event - _drift) / scale);
+    if (real == 0)
+      real = 1;
+    if (real > target - _micros)
+      real = target - _micros;
+
+    double rtc = real * scale + _drift;
+    uint32_t step = (rtc >= event) ? event : static_cast<uint32_t>(rtc);
+    _drift = rtc - step;
+    _micros += real;
+    _step(step);
+  }
+  return _micros - start;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Skip the seconds up to the next event in one step
+  @param  target micros() at the end of advance()
+  @param  scale RTC time per real time
+  @return True if seconds were skipped
+  @details The next events are the end of the advance() and the next
+  second that sets an alarm flag. The phase, the drift of the crystal and
+  the TCXO conversions are carried over as if the seconds were ticked.
+*/
+/**************************************************************************/
+bool DS3231Sim::_jump(uint64_t target, double scale) {
+  if (_sqw_frequency() != 0 || _conversion)
+    return false;
+
+  // whole seconds that end before the target, the last one is ticked
+  double available = (target - _micros) * scale + _drift - (1000000UL - _phase);
+  if (available < 2000000.0)
+    return false;
+  uint32_t seconds = static_cast<uint32_t>(available / 1000000.0);
+  seconds = _quiet(seconds - 1);
+  if (seconds < 2)
+    return false;
+
+  double rtc = (1000000UL - _phase) + (seconds - 1) * 1000000.0;
+  uint64_t real = static_cast<uint64_t>((rtc - _drift) / scale + 1);
+  _drift = real * scale + _drift - rtc;
+  _micros += real;
+  _phase = 0;
+  _skip(seconds);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Number of the next seconds that do not set an alarm flag
+  @param  max upper limit of the result
+  @return seconds from the current time, up to max
+*/
+/**************************************************************************/
+uint32_t DS3231Sim::_quiet(uint32_t max) const {
+  uint32_t quiet = max;
+  for (uint8_t alarm = 1; alarm <= 2; alarm++) {
+    if (_reg[0x0F] & alarm)
+      continue;  // the flag is already set, a match changes nothing
+    uint32_t next = _next_match(alarm, quiet);
+    if (next <= quiet)
+      quiet = next - 1;
+  }
+  return quiet;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Seconds to the next match of an alarm, searched day by day
+  @param  alarm 1 or 2
+  @param  max search limit in seconds
+  @return seconds from now to the match (at least 1), max + 1 if none
+*/
+/**************************************************************************/
+uint32_t DS3231Sim::_next_match(uint8_t alarm, uint32_t max) const {
+  const uint8_t *a = &_reg[(alarm == 1) ? 0x07 : 0x0B];
+  uint8_t sec_reg = (alarm == 1) ? a[0] : 0x00;       // Alarm 2 matches at 00 seconds
+  const uint8_t *r = (alarm == 1) ? a + 1 : a;         // minutes, hours, day/date
+  uint32_t second_of_day = bcd2bin(_reg[0x02] & 0x3F) * 3600UL + bcd2bin(_reg[0x01]) * 60 + bcd2bin(_reg[0x00]);
+  uint32_t days = _chip_days();
+  uint8_t dow = _reg[0x03];
+
+  for (uint32_t d = 0; d * 86400UL < max + second_of_day; d++) {
+    uint16_t y;
+    uint8_t m, date;
+    _chip_date(days + d, &y, &m, &date);
+    uint8_t day_dow = (dow - 1 + d) % 7 + 1;
+    bool day = (r[2] & 0x40) ? (r[2] & 0x0F) == day_dow : (r[2] & 0x3F) == bin2bcd(date);
+    if (!(r[2] & 0x80) && !day)
+      continue;
+
+    uint32_t from = (d == 0) ? second_of_day + 1 : 0;
+    for (uint32_t t = from; t < 86400UL; t++) {
+      uint8_t hour = t / 3600, minute = (t / 60) % 60, second = t % 60;
+      if (!(r[1] & 0x80) && (r[1] & 0x3F) != bin2bcd(hour)) {
+        t = t - t % 3600 + 3599;    // next hour
+        continue;
+      }
+      if (!(r[0] & 0x80) && (r[0] & 0x7F) != bin2bcd(minute)) {
+        t = t - t % 60 + 59;        // next minute
+        continue;
+      }
+      if (((alarm == 1) && (sec_reg & 0x80)) || (sec_reg & 0x7F) == bin2bcd(second))
+        return d * 86400UL + t - second_of_day;
+    }
+  }
+  return max + 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Add seconds to the time counters without any alarm match
+*/
+/**************************************************************************/
+void DS3231Sim::_skip(uint32_t seconds) {
+  uint32_t second_of_day = bcd2bin(_reg[0x02] & 0x3F) * 3600UL + bcd2bin(_reg[0x01]) * 60 + bcd2bin(_reg[0x00]) + seconds;
+  uint32_t days = second_of_day / 86400UL;
+  second_of_day %= 86400UL;
+
+  if (days) {
+    uint16_t y;
+    uint8_t m, d;
+    _chip_date(_chip_days() + days, &y, &m, &d);
+    _reg[0x03] = (_reg[0x03] - 1 + days) % 7 + 1;
+    _reg[0x04] = bin2bcd(d);
+    _reg[0x05] = bin2bcd(m) | ((y >= 100) ? 0x80 : 0);
+    _reg[0x06] = bin2bcd(y % 100);
+  }
+  _reg[0x02] = bin2bcd(second_of_day / 3600);
+  _reg[0x01] = bin2bcd((second_of_day / 60) % 60);
+  _reg[0x00] = bin2bcd(second_of_day % 60);
+
+  if (seconds >= _seconds_to_tcxo) {
+    _seconds_to_tcxo = SIM_TCXO_PERIOD - (seconds - _seconds_to_tcxo) % SIM_TCXO_PERIOD;
+    _convert();
+  }
+  else {
+    _seconds_to_tcxo -= seconds;
+  }
+}
+
+// Days before each month, the chip treats every year divisible by 4 as a leap year
+static const uint16_t chipMonthStart[] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
+
+/**************************************************************************/
+/*!
+  @brief  Days since 00/01/01 of the calendar of the chip, the century bit
+  counts as year 100
+*/
+/**************************************************************************/
+uint32_t DS3231Sim::_chip_days(void) const {
+  uint16_t y = bcd2bin(_reg[0x06]) + ((_reg[0x05] & 0x80) ? 100 : 0);
+  uint8_t m = bcd2bin(_reg[0x05] & 0x1F);
+  uint8_t d = bcd2bin(_reg[0x04]);
+  return 365UL * y + (y + 3) / 4 + chipMonthStart[m - 1] + ((m > 2 && y % 4 == 0) ? 1 : 0) + d - 1;
+}
+
+void DS3231Sim::_chip_date(uint32_t days, uint16_t *y, uint8_t *m, uint8_t *d) {
+  days %= 200 * 365UL + 50;  // the century bit wraps after year 199
+  uint16_t year = days / 366;
+  while (365UL * (year + 1) + (year + 4) / 4 <= days)
+    year++;
+  uint16_t yday = days - (365UL * year + (year + 3) / 4);
+  uint8_t leap = (year % 4 == 0) ? 1 : 0;
+  uint8_t month = 1;
+  while (month < 12 && yday >= chipMonthStart[month] + ((month >= 2) ? leap : 0))
+    month++;
+  *y = year;
+  *m = month;
+  *d = yday - chipMonthStart[month - 1] - ((month > 2) ? leap : 0) + 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Oscillator frequency error including the aging offset
+  @return ppm, positive when the RTC runs fast
+  @details One LSB of the aging register is about 0.1ppm, a positive value
+  slows the oscillator down.
+*/
+/**************************************************************************/
+float DS3231Sim::frequencyError(void) const {
+  return _crystal_ppm - 0.1f * static_cast<int8_t>(_reg[0x10]);
+}
+
+/**************************************************************************/
+/*!
+  @brief  State of the INT pin in interrupt mode
+  @return True when the pin is pulled low by an enabled alarm
+*/
+/**************************************************************************/
+bool DS3231Sim::intLow(void) const {
+  if (!(_reg[0x0E] & 0x04))
+    return false;
+  return (_reg[0x0E] & _reg[0x0F] & 0x03) != 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Level of the INT/SQW pin
+  @return True for high (released), the square wave is low for the first
+  half of each cycle, starting with the second boundary
+*/
+/**************************************************************************/
+bool DS3231Sim::sqwLevel(void) const {
+  uint32_t f = _sqw_frequency();
+  if (f == 0)
+    return !intLow();
+  return ((uint64_t) _phase * f % 1000000UL) >= 500000UL;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Register write with the access rules of the chip
+*/
+/**************************************************************************/
+void DS3231Sim::_write(uint8_t addr, uint8_t val) {
+  switch (addr) {
+    case 0x00:
+      _reg[addr] = val & 0x7F;
+      _phase = 0;  // writing the seconds resets the countdown chain
+      _drift = 0;
+      break;
+    case 0x0E:
+      if ((val & 0x20) && !(_reg[0x0F] & 0x04)) {
+        _conversion = SIM_CONVERSION_US;
+        _reg[0x0F] |= 0x04;
+      }
+      _reg[addr] = val;
+      break;
+    case 0x0F:
+      // flags can only be cleared, BSY is read-only, only EN32kHz is writable
+      _reg[addr] = (_reg[addr] & val & 0x83) | (val & 0x08) | (_reg[addr] & 0x04);
+      break;
+    case 0x11:
+    case 0x12:
+      break;
+    default:
+      _reg[addr] = val;
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  Advance the RTC time, never past the next event
+*/
+/**************************************************************************/
+void DS3231Sim::_step(uint32_t usec) {
+  uint32_t before = _phase;
+  _phase += usec;
+
+  if (_conversion) {
+    _conversion = (usec >= _conversion) ? 0 : _conversion - usec;
+    if (_conversion == 0)
+      _convert();
+  }
+
+  if (_phase >= 1000000UL) {
+    _phase -= 1000000UL;
+    _tick();
+    return;
+  }
+
+  uint32_t f = _sqw_frequency();
+  if (f > 1 && _isr) {
+    uint64_t edges = (uint64_t) _phase * f / 1000000UL - (uint64_t) before * f / 1000000UL;
+    while (edges--)
+      _isr();
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  One second: BCD counters, alarm matching and TCXO conversion
+*/
+/**************************************************************************/
+void DS3231Sim::_tick(void) {
+  static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  bool was_low = intLow();
+
+  uint8_t sec = bcd2bin(_reg[0x00]) + 1;
+  if (sec == 60) {
+    sec = 0;
+    uint8_t min = bcd2bin(_reg[0x01]) + 1;
+    if (min == 60) {
+      min = 0;
+      uint8_t hour = bcd2bin(_reg[0x02] & 0x3F) + 1;
+      if (hour == 24) {
+        hour = 0;
+        _reg[0x03] = (_reg[0x03] % 7) + 1;
+        uint8_t year = bcd2bin(_reg[0x06]);
+        uint8_t month = bcd2bin(_reg[0x05] & 0x1F);
+        uint8_t date = bcd2bin(_reg[0x04]) + 1;
+        // the chip treats every year divisible by 4 as a leap year
+        uint8_t last = daysInMonth[month - 1] + ((month == 2 && year % 4 == 0) ? 1 : 0);
+        if (date > last) {
+          date = 1;
+          month++;
+          if (month > 12) {
+            month = 1;
+            year++;
+            if (year == 100) {
+              year = 0;
+              _reg[0x05] ^= 0x80;  // Century
+            }
+            _reg[0x06] = bin2bcd(year);
+          }
+          _reg[0x05] = (_reg[0x05] & 0x80) | bin2bcd(month);
+        }
+        _reg[0x04] = bin2bcd(date);
+      }
+      _reg[0x02] = bin2bcd(hour);
+    }
+    _reg[0x01] = bin2bcd(min);
+  }
+  _reg[0x00] = bin2bcd(sec);
+
+  if (_match_alarm1())
+    _reg[0x0F] |= 0x01;
+  if (sec == 0 && _match_alarm2())
+    _reg[0x0F] |= 0x02;
+
+  if (--_seconds_to_tcxo == 0) {
+    _seconds_to_tcxo = SIM_TCXO_PERIOD;
+    _convert();
+  }
+
+  if (_isr) {
+    if (_sqw_frequency() > 0 || (!was_low && intLow()))
+      _isr();
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  Temperature conversion result, clears CONV and BSY
+*/
+/**************************************************************************/
+void DS3231Sim::_convert(void) {
+  _reg[0x11] = static_cast<uint8_t>(_temperature >> 2);
+  _reg[0x12] = static_cast<uint8_t>((_temperature & 0x03) << 6);
+  _reg[0x0E] &= ~0x20;
+  _reg[0x0F] &= ~0x04;
+}
+
+bool DS3231Sim::_match_alarm1(void) const {
+  const uint8_t *a = &_reg[0x07];
+  bool day = (a[3] & 0x40) ? (a[3] & 0x0F) == _reg[0x03] : (a[3] & 0x3F) == _reg[0x04];
+  return ((a[0] & 0x80) || (a[0] & 0x7F) == _reg[0x00])
+      && ((a[1] & 0x80) || (a[1] & 0x7F) == _reg[0x01])
+      && ((a[2] & 0x80) || (a[2] & 0x3F) == (_reg[0x02] & 0x3F))
+      && ((a[3] & 0x80) || day);
+}
+
+bool DS3231Sim::_match_alarm2(void) const {
+  const uint8_t *a = &_reg[0x0B];
+  bool day = (a[2] & 0x40) ? (a[2] & 0x0F) == _reg[0x03] : (a[2] & 0x3F) == _reg[0x04];
+  return ((a[0] & 0x80) || (a[0] & 0x7F) == _reg[0x01])
+      && ((a[1] & 0x80) || (a[1] & 0x3F) == (_reg[0x02] & 0x3F))
+      && ((a[2] & 0x80) || day);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Square wave frequency
+  @return 0 when INTCN is set, otherwise 1, 1024, 4096 or 8192
+*/
+/**************************************************************************/
+uint32_t DS3231Sim::_sqw_frequency(void) const {
+  static const uint32_t rates[] = {1, 1024, 4096, 8192};
+  if (_reg[0x0E] & 0x04)
+    return 0;
+  return rates[(_reg[0x0E] >> 3) & 0x03];
+}
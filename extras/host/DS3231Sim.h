@@ -0,0 +1,72 @@
+#ifndef __DS3231_SIM_H__
+#define __DS3231_SIM_H__
+// Register model of the DS3231 for host builds. It runs on virtual time,
+// attach it to a TwoWire stand-in and call advance() to move the clock:
+//
+//   DS3231Sim sim;
+//   Wire.attach(DS3231_ADDRESS, &sim);
+//   sim.advance(1000000);   // one second later
+//
+// The model covers the BCD time counters (24-hour mode) with the century
+// bit, both alarms and their flags, INTCN/SQW, EN32kHz, OSF, BSY/CONV and
+// the aging offset applied to a simulated crystal error. With INTCN set,
+// advance() jumps from one alarm match to the next instead of ticking.
+#include "Wire.h"
+
+#define DS3231_SIM_REGISTERS 19
+
+class DS3231Sim : public TwoWireDevice
+{
+public:
+  DS3231Sim() { powerOn(); }
+
+  bool onWrite(const uint8_t *data, size_t len) override;
+  bool onRead(uint8_t *data, size_t len) override;
+
+  void powerOn(void);
+  void stopOscillator(void) { _reg[0x0F] |= 0x80; }
+  void advance(uint64_t usec);
+  uint64_t advanceUntilInterrupt(uint64_t usec);
+  uint64_t micros(void) const { return _micros; }
+
+  void setTemperature(float celsius) { _temperature = static_cast<int16_t>(celsius * 4.0f); }
+  void setCrystalError(float ppm) { _crystal_ppm = ppm; }
+  float frequencyError(void) const;
+  void onInterrupt(void (*isr)(void)) { _isr = isr; }
+
+  bool intLow(void) const;
+  bool sqwLevel(void) const;
+  bool out32kEnabled(void) const { return _reg[0x0F] & 0x08; }
+  uint8_t reg(uint8_t addr) const { return _reg[addr]; }
+  void setReg(uint8_t addr, uint8_t val) { _reg[addr] = val; }
+  uint32_t phase(void) const { return _phase; }
+
+private:
+  uint8_t _reg[DS3231_SIM_REGISTERS]{0};
+  uint8_t _pointer{0};
+  uint64_t _micros{0};     // virtual real time
+  uint32_t _phase{0};      // microseconds into the current RTC second
+  double _drift{0};        // fractional microseconds carried by the crystal error
+  float _crystal_ppm{0};
+  int16_t _temperature{100};  // quarter degrees
+  uint32_t _conversion{0};    // remaining time of a forced conversion
+  uint8_t _seconds_to_tcxo{64};
+  void (*_isr)(void){nullptr};
+
+  uint64_t _advance(uint64_t usec, bool until_int);
+  void _write(uint8_t addr, uint8_t val);
+  bool _jump(uint64_t target, double scale);
+  uint32_t _quiet(uint32_t max) const;
+  uint32_t _next_match(uint8_t alarm, uint32_t max) const;
+  void _skip(uint32_t seconds);
+  uint32_t _chip_days(void) const;
+  static void _chip_date(uint32_t days, uint16_t *y, uint8_t *m, uint8_t *d);
+  void _step(uint32_t usec);
+  void _tick(void);
+  void _convert(void);
+  bool _match_alarm1(void) const;
+  bool _match_alarm2(void) const;
+  uint32_t _sqw_frequency(void) const;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "LinuxWire.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+int LinuxI2C::ioctl(int fd, unsigned long request, void *arg) {
+  return ::ioctl(fd, request, arg);
+}
+
+int LinuxI2CSim::ioctl(int fd, unsigned long request, void *arg) {
+  (void) fd;
+  if (request != I2C_RDWR) {
+    errno = ENOTTY;
+    return -1;
+  }
+  _calls++;
+
+  struct i2c_rdwr_ioctl_data *data = static_cast<struct i2c_rdwr_ioctl_data *>(arg);
+  if (data->nmsgs > I2C_RDWR_IOCTL_MAX_MSGS) {
+    errno = EINVAL;
+    return -1;
+  }
+  for (uint32_t i = 0; i < data->nmsgs; i++) {
+    const struct i2c_msg &msg = data->msgs[i];
+    TwoWireDevice *device = nullptr;
+    for (uint8_t d = 0; d < TWOWIRE_MAX_DEVICES; d++) {
+      if (_devices[d] && _addresses[d] == msg.addr)
+        device = _devices[d];
+    }
+    bool ack = device && (msg.len == 0
+      || ((msg.flags & I2C_M_RD) ? device->onRead(msg.buf, msg.len) : device->onWrite(msg.buf, msg.len)));
+    if (!ack) {
+      errno = ENXIO;
+      return -1;
+    }
+  }
+  return static_cast<int>(data->nmsgs);
+}
+
+bool LinuxI2CSim::attach(uint16_t address, TwoWireDevice *device) {
+  for (uint8_t i = 0; i < TWOWIRE_MAX_DEVICES; i++) {
+    if (_devices[i] == nullptr || _addresses[i] == address) {
+      _addresses[i] = address;
+      _devices[i] = device;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Open the adapter, e.g. "/dev/i2c-1"
+bool LinuxWire::open(const char *path) {
+  close();
+  _fd = ::open(path, O_RDWR);
+  return _fd >= 0;
+}
+
+void LinuxWire::close(void) {
+  if (_fd >= 0)
+    ::close(_fd);
+  _fd = -1;
+}
+
+// Send the writes queued since beginBatch() in one ioctl, returns 0 or the
+// endTransmission() error code of the batch
+uint8_t LinuxWire::endBatch(void) {
+  _batch = false;
+  return _queued ? _submit(_queued) : 0;
+}
+
+// In a batch the writes are queued, they go out with the next read (the
+// error of the read is then the error of the whole batch) or endBatch()
+uint8_t LinuxWire::_transfer(uint8_t address, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen) {
+  if (_batch && rlen == 0) {
+    if (_queued == LINUXWIRE_BATCH) {
+      uint8_t err = _submit(_queued);
+      if (err)
+        return err;
+    }
+    memcpy(_queue[_queued], wbuf, wlen);
+    struct i2c_msg &msg = _msgs[_queued++];
+    msg.addr = address;
+    msg.flags = 0;
+    msg.len = static_cast<uint16_t>(wlen);
+    msg.buf = _queue[_queued - 1];
+    _count(wlen, 0, false);
+    return 0;
+  }
+
+  uint8_t n = _queued;
+  if (wlen || rlen == 0) {  // an empty write probes the address
+    _msgs[n].addr = address;
+    _msgs[n].flags = 0;
+    _msgs[n].len = static_cast<uint16_t>(wlen);
+    _msgs[n++].buf = const_cast<uint8_t *>(wbuf);
+  }
+  if (rlen) {
+    _msgs[n].addr = address;
+    _msgs[n].flags = I2C_M_RD;
+    _msgs[n].len = static_cast<uint16_t>(rlen);
+    _msgs[n++].buf = rbuf;
+  }
+  uint8_t err = _submit(n);
+  _count(wlen, rlen, err != 0);
+  return err;
+}
+
+uint8_t LinuxWire::_submit(uint8_t nmsgs) {
+  struct i2c_rdwr_ioctl_data data;
+  data.msgs = _msgs;
+  data.nmsgs = nmsgs;
+  _queued = 0;
+  _syscalls++;
+  if (_i2c->ioctl(_fd, I2C_RDWR, &data) >= 0)
+    return 0;
+  return (errno == ENXIO || errno == EREMOTEIO) ? 2 : 4;
+}
@@ -0,0 +1,63 @@
+#ifndef __HOST_LINUX_WIRE_H__
+#define __HOST_LINUX_WIRE_H__
+// TwoWire backend for the Linux i2c-dev interface (/dev/i2c-N), so that the
+// library runs on a single-board computer. Each transaction is a single
+// I2C_RDWR ioctl, a register read is a write and a read message joined by
+// a repeated START.
+#include "Wire.h"
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#define LINUXWIRE_BATCH 16  // writes queued by beginBatch(), at most I2C_RDWR_IOCTL_MAX_MSGS - 2
+
+// The ioctl layer, replace it to run without hardware
+class LinuxI2C
+{
+public:
+  virtual ~LinuxI2C() {}
+  virtual int ioctl(int fd, unsigned long request, void *arg);
+};
+
+// ioctl layer routing the I2C_RDWR messages to simulated devices, e.g.
+// DS3231Sim, a NAK fails the ioctl with ENXIO as the i2c-dev driver does
+class LinuxI2CSim : public LinuxI2C
+{
+public:
+  int ioctl(int fd, unsigned long request, void *arg) override;
+  bool attach(uint16_t address, TwoWireDevice *device);
+  uint32_t calls(void) const { return _calls; }
+
+private:
+  uint16_t _addresses[TWOWIRE_MAX_DEVICES]{0};
+  TwoWireDevice *_devices[TWOWIRE_MAX_DEVICES]{nullptr};
+  uint32_t _calls{0};
+};
+
+class LinuxWire : public TwoWire
+{
+public:
+  explicit LinuxWire(LinuxI2C *i2c = nullptr) : _i2c(i2c ? i2c : &_kernel) {}
+  ~LinuxWire() override { close(); }
+  bool open(const char *path);
+  void close(void);
+  void beginBatch(void) { _batch = true; }
+  uint8_t endBatch(void);
+  uint32_t syscalls(void) const { return _syscalls; }
+
+protected:
+  uint8_t _transfer(uint8_t address, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen) override;
+
+private:
+  LinuxI2C _kernel;
+  LinuxI2C *_i2c;
+  int _fd{-1};
+  bool _batch{false};
+  uint8_t _queued{0};
+  uint8_t _queue[LINUXWIRE_BATCH][BUFFER_LENGTH];
+  struct i2c_msg _msgs[LINUXWIRE_BATCH + 2];
+  uint32_t _syscalls{0};
+
+  uint8_t _submit(uint8_t nmsgs);
+};
+
+#endif
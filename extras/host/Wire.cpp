@@ -0,0 +1,119 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address) {
+  _tx_address = address;
+  _tx_len = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (_tx_len >= BUFFER_LENGTH)
+    return 0;
+  _tx_buffer[_tx_len++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t len) {
+  size_t n = 0;
+  while (n < len && write(data[n]))
+    n++;
+  return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  if (!sendStop) {
+    // the write phase goes out with the read that follows the repeated START
+    _pending = true;
+    return 0;
+  }
+  _pending = false;
+  uint8_t err = _inject(_tx_len, 0);
+  return err ? err : _transfer(_tx_address, _tx_buffer, _tx_len, nullptr, 0);
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop) {
+  (void) sendStop;
+  if (quantity > BUFFER_LENGTH)
+    quantity = BUFFER_LENGTH;
+  _rx_index = 0;
+  _rx_len = 0;
+
+  bool combined = _pending && _tx_address == address;
+  _pending = false;
+  uint8_t err = _inject(combined ? _tx_len : 0, quantity);
+  if (err == 0)
+    err = _transfer(static_cast<uint8_t>(address), _tx_buffer, combined ? _tx_len : 0, _rx_buffer, quantity);
+  if (err)
+    return 0;
+  _rx_len = quantity;
+  return quantity;
+}
+
+bool TwoWire::attach(uint8_t address, TwoWireDevice *device) {
+  for (uint8_t i = 0; i < TWOWIRE_MAX_DEVICES; i++) {
+    if (_devices[i] == nullptr || _addresses[i] == address) {
+      _addresses[i] = address;
+      _devices[i] = device;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TwoWire::detach(uint8_t address) {
+  for (uint8_t i = 0; i < TWOWIRE_MAX_DEVICES; i++) {
+    if (_devices[i] && _addresses[i] == address)
+      _devices[i] = nullptr;
+  }
+}
+
+// Estimated time on the wire at the given SCL clock
+uint32_t TwoWire::busMicros(uint32_t speed) const {
+  return static_cast<uint32_t>((uint64_t) _stats.bits * 1000000ULL / speed);
+}
+
+uint8_t TwoWire::_transfer(uint8_t address, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen) {
+  TwoWireDevice *device = nullptr;
+  for (uint8_t i = 0; i < TWOWIRE_MAX_DEVICES; i++) {
+    if (_devices[i] && _addresses[i] == address)
+      device = _devices[i];
+  }
+
+  bool nak = (device == nullptr)
+    || (wlen && !device->onWrite(wbuf, wlen))
+    || (rlen && !device->onRead(rbuf, rlen));
+  _count(wlen, rlen, nak);
+  return nak ? 2 : 0;
+}
+
+// Applies the faults armed by failNext() and stallNext() to a transaction,
+// returns the error of a failed one after counting it
+uint8_t TwoWire::_inject(size_t wlen, size_t rlen) {
+  if (_take(_stall_count))
+    delayMicroseconds(_stall_usec);
+  if (!_take(_fail_count))
+    return 0;
+  _count(wlen, rlen, true);
+  return _fail_error;
+}
+
+bool TwoWire::_take(std::atomic<uint32_t> &count) {
+  uint32_t n = count.load();
+  while (n && !count.compare_exchange_weak(n, n - 1)) {}
+  return n != 0;
+}
+
+// START + address/ACK for each phase, 9 clocks per data byte, STOP
+void TwoWire::_count(size_t wlen, size_t rlen, bool nak) {
+  uint32_t phases = (wlen ? 1 : 0) + (rlen ? 1 : 0);
+  if (phases == 0)
+    phases = 1;  // address only, e.g. a bus scan
+  uint32_t bits = phases * 10 + (wlen + rlen) * 9 + 1;
+  _stats.transactions++;
+  _stats.bytes += wlen + rlen;
+  _stats.bits += bits;
+  if (nak)
+    _stats.naks++;
+  hostElapse((uint64_t) bits * 1000000ULL / _clock);
+}
@@ -0,0 +1,91 @@
+#ifndef __HOST_WIRE_H__
+#define __HOST_WIRE_H__
+// TwoWire stand-in for building the library on a host. Transfers are routed
+// to TwoWireDevice objects attached to the bus (e.g. DS3231Sim), or to a
+// backend that overrides _transfer().
+#include "Arduino.h"
+#include <atomic>
+
+#define BUFFER_LENGTH       32
+#define TWOWIRE_MAX_DEVICES 8
+
+// I2C target on the simulated bus
+class TwoWireDevice
+{
+public:
+  virtual ~TwoWireDevice() {}
+  virtual bool onWrite(const uint8_t *data, size_t len) = 0;  // false to NAK
+  virtual bool onRead(uint8_t *data, size_t len) = 0;
+};
+
+// Bus usage counters
+typedef struct {
+  uint32_t transactions;  // START ... STOP sequences
+  uint32_t bytes;         // data bytes excluding the address bytes
+  uint32_t bits;          // SCL clocks including START, address, ACK and STOP
+  uint32_t naks;          // failed transactions, injected faults included
+} TwoWireStats_t;
+
+class TwoWire
+{
+public:
+  virtual ~TwoWire() {}
+  void begin(void) {}
+  void end(void) {}
+  void setClock(uint32_t clock) { _clock = clock; }
+  uint32_t getClock(void) const { return _clock; }
+
+  void beginTransmission(uint8_t address);
+  void beginTransmission(int address) { beginTransmission(static_cast<uint8_t>(address)); }
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t len);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(int address, int quantity, int sendStop = 1);
+  int available(void) { return _rx_len - _rx_index; }
+  int read(void) { return (_rx_index < _rx_len) ? _rx_buffer[_rx_index++] : -1; }
+  int peek(void) { return (_rx_index < _rx_len) ? _rx_buffer[_rx_index] : -1; }
+
+  bool attach(uint8_t address, TwoWireDevice *device);
+  void detach(uint8_t address);
+
+  const TwoWireStats_t &stats(void) const { return _stats; }
+  void resetStats(void) { memset(&_stats, 0, sizeof(_stats)); }
+  uint32_t busMicros(uint32_t speed) const;
+
+  // Fault injection, can be armed from another thread while drivers use the
+  // bus: the next count transactions fail with the endTransmission() error
+  // (2 NAK on the address, 3 NAK on data, 4 other, 5 timeout), or are held
+  // for usec more as by a target stretching SCL.
+  void failNext(uint32_t count, uint8_t error = 2) { _fail_error = error; _fail_count = count; }
+  void stallNext(uint32_t count, uint32_t usec) { _stall_usec = usec; _stall_count = count; }
+
+protected:
+  // A complete transaction: write wlen bytes, then with a repeated START
+  // read rlen bytes. Returns 0 on success or the endTransmission() error code.
+  virtual uint8_t _transfer(uint8_t address, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen);
+  void _count(size_t wlen, size_t rlen, bool nak);
+  uint8_t _inject(size_t wlen, size_t rlen);
+
+private:
+  uint32_t _clock{100000};
+  uint8_t _tx_address{0};
+  uint8_t _tx_buffer[BUFFER_LENGTH]{0};
+  size_t _tx_len{0};
+  bool _pending{false};  // endTransmission(false) held for the next requestFrom()
+  uint8_t _rx_buffer[BUFFER_LENGTH]{0};
+  int _rx_len{0};
+  int _rx_index{0};
+  uint8_t _addresses[TWOWIRE_MAX_DEVICES]{0};
+  TwoWireDevice *_devices[TWOWIRE_MAX_DEVICES]{nullptr};
+  TwoWireStats_t _stats{};
+  std::atomic<uint32_t> _fail_count{0};
+  std::atomic<uint8_t> _fail_error{2};
+  std::atomic<uint32_t> _stall_count{0};
+  std::atomic<uint32_t> _stall_usec{0};
+
+  static bool _take(std::atomic<uint32_t> &count);
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,191 @@
+// DS3231Async with DS3231WireTransport on DS3231Sim. Checks that reads
+// queued back to back over close registers are served by one burst and
+// those far apart are not, that a write keeps its place between reads, the
+// queue full, a transport that does not start a transaction, and the error
+// of a failed read given to every callback of its burst.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o async extras/host/tests/async.cpp
+//     src/DS3231.cpp src/DS3231Async.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./async
+#include <DS3231Async.h>
+#include <DS3231Sim.h>
+#include <vector>
+
+static DS3231Sim sim;
+static TwoWire bus;
+static DS3231 rtc;
+static DS3231WireTransport transport(&bus);
+static DS3231Async rtcAsync;
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+typedef struct {
+  DS3231_ASYNC_OP_t op;
+  uint8_t error;
+  DS3231Snapshot snap;
+} Result_t;
+
+static std::vector<Result_t> results;
+
+static void done(DS3231_ASYNC_OP_t op, const DS3231Snapshot *snap, uint8_t error) {
+  results.push_back(Result_t{op, error, *snap});
+}
+
+// Transport that refuses every transaction
+class RefusingTransport : public DS3231Transport
+{
+public:
+  bool start(const uint8_t *, uint8_t, uint8_t *, uint8_t) override { return false; }
+  int8_t poll(void) override { return 0; }
+};
+
+// Polls until the queue is empty, returns the transactions on the bus
+static uint32_t drain(const char *what) {
+  uint32_t before = bus.stats().transactions;
+  for (uint8_t i = 0; !rtcAsync.poll(); i++) {
+    if (i > 50) {
+      FAIL("%s: queue not drained", what);
+      break;
+    }
+  }
+  return bus.stats().transactions - before;
+}
+
+static bool sameTime(const DS3231Snapshot &snap) {
+  for (uint8_t r = DS3231_TIME; r < DS3231_TIME + 7; r++)
+    if (snap.reg[r] != sim.reg(r))
+      return false;
+  return true;
+}
+
+static void testMerge(void) {
+  results.clear();
+  rtcAsync.startRead(DS3231_ASYNC_NOW, done);
+  rtcAsync.startRead(DS3231_ASYNC_SNAPSHOT, done);
+  rtcAsync.startRead(DS3231_ASYNC_TEMPERATURE, done);
+  uint32_t before = bus.stats().bytes;
+  uint32_t tx = drain("merge");
+  // one write of the register address and one read of the 19 registers
+  if (tx != 1 || bus.stats().bytes - before != 1 + DS3231_REGISTERS)
+    FAIL("merge: %u transactions of %u bytes for now + snapshot + temperature, expected 1 of %u",
+      tx, bus.stats().bytes - before, 1 + DS3231_REGISTERS);
+  if (results.size() != 3 || results[0].op != DS3231_ASYNC_NOW || results[1].op != DS3231_ASYNC_SNAPSHOT
+      || results[2].op != DS3231_ASYNC_TEMPERATURE) {
+    FAIL("merge: %u callbacks, or out of order", (unsigned) results.size());
+    return;
+  }
+  for (const Result_t &r : results)
+    if (r.error || !sameTime(r.snap) || r.snap.reg[DS3231_TEMPERATURE] != sim.reg(DS3231_TEMPERATURE))
+      FAIL("merge: callback of op %u with error %u or wrong registers", r.op, r.error);
+
+  // the time and the temperature are too far apart for one burst
+  results.clear();
+  rtcAsync.startRead(DS3231_ASYNC_NOW, done);
+  rtcAsync.startRead(DS3231_ASYNC_TEMPERATURE, done);
+  before = bus.stats().bytes;
+  tx = drain("no merge");
+  if (tx != 2 || bus.stats().bytes - before != 1 + 7 + 1 + 2)
+    FAIL("no merge: %u transactions of %u bytes for now + temperature, expected 2 of 11", tx, bus.stats().bytes - before);
+  if (results.size() != 2 || !sameTime(results[0].snap) || results[1].snap.temperatureRaw() != rtc.getTemperatureRaw())
+    FAIL("no merge: %u callbacks or wrong registers", (unsigned) results.size());
+}
+
+static void testOrder(void) {
+  results.clear();
+  static const uint8_t minutes[] = {DS3231_TIME + 1, 0x42};
+  rtcAsync.startRead(DS3231_ASYNC_NOW, done);
+  rtcAsync.startWrite(minutes, sizeof(minutes), done);
+  rtcAsync.startRead(DS3231_ASYNC_NOW, done);
+  uint32_t tx = drain("order");
+  if (tx != 3 || results.size() != 3) {
+    FAIL("order: %u transactions and %u callbacks for read, write, read, expected 3 and 3", tx, (unsigned) results.size());
+    return;
+  }
+  if (results[1].op != DS3231_ASYNC_WRITE || results[1].error)
+    FAIL("order: the write was not second or failed");
+  if (results[0].snap.reg[DS3231_TIME + 1] == 0x42 || results[2].snap.reg[DS3231_TIME + 1] != 0x42)
+    FAIL("order: minutes %02x before and %02x after the write", results[0].snap.reg[DS3231_TIME + 1], results[2].snap.reg[DS3231_TIME + 1]);
+}
+
+static void testQueueFull(void) {
+  results.clear();
+  static const uint8_t aging[] = {DS3231_AGING, 0};
+  for (uint8_t i = 0; i < DS3231_ASYNC_QUEUE_SIZE; i++)
+    if (!rtcAsync.startRead(i % 2 ? DS3231_ASYNC_TEMPERATURE : DS3231_ASYNC_NOW, done))
+      FAIL("queue: read %u refused", i);
+  if (rtcAsync.pending() != DS3231_ASYNC_QUEUE_SIZE)
+    FAIL("queue: %u pending", rtcAsync.pending());
+  if (rtcAsync.startRead(DS3231_ASYNC_NOW, done) || rtcAsync.startWrite(aging, sizeof(aging), done))
+    FAIL("queue: a request accepted with the queue full");
+  if (rtcAsync.startRead(DS3231_ASYNC_WRITE, done))
+    FAIL("queue: a read of DS3231_ASYNC_WRITE accepted");
+
+  // the first transaction started, its slot freed once it completes
+  rtcAsync.poll();
+  if (rtcAsync.startRead(DS3231_ASYNC_NOW, done))
+    FAIL("queue: accepted while the first request is in progress");
+  while (rtcAsync.pending() == DS3231_ASYNC_QUEUE_SIZE)
+    rtcAsync.poll();
+  if (!rtcAsync.startWrite(aging, sizeof(aging), done))
+    FAIL("queue: refused after a request completed");
+  drain("queue");
+  if (results.size() != DS3231_ASYNC_QUEUE_SIZE + 1)
+    FAIL("queue: %u callbacks, expected %u", (unsigned) results.size(), DS3231_ASYNC_QUEUE_SIZE + 1);
+}
+
+static void testErrors(void) {
+  // a failed read completes every request of its burst, the Wire API only
+  // reports a short read; a failed write gives the endTransmission() error
+  results.clear();
+  static const uint8_t aging[] = {DS3231_AGING, 0};
+  rtcAsync.startRead(DS3231_ASYNC_NOW, done);
+  rtcAsync.startRead(DS3231_ASYNC_SNAPSHOT, done);
+  rtcAsync.startRead(DS3231_ASYNC_TEMPERATURE, done);
+  rtcAsync.startWrite(aging, sizeof(aging), done);
+  bus.failNext(2, DS3231_ERR_NACK_ADDRESS);
+  drain("error");
+  if (results.size() != 4) {
+    FAIL("error: %u callbacks, expected 4", (unsigned) results.size());
+    return;
+  }
+  for (uint8_t i = 0; i < 3; i++)
+    if (results[i].error != DS3231_ERR_READ)
+      FAIL("error: read op %u completed with error %u, expected %u", results[i].op, results[i].error, DS3231_ERR_READ);
+  if (results[3].error != DS3231_ERR_NACK_ADDRESS)
+    FAIL("error: write completed with error %u, expected %u", results[3].error, DS3231_ERR_NACK_ADDRESS);
+
+  // a transport that does not start the transaction
+  RefusingTransport refusing;
+  DS3231Async other;
+  other.begin(&refusing);
+  results.clear();
+  other.startRead(DS3231_ASYNC_NOW, done);
+  other.startWrite(aging, sizeof(aging), done);
+  for (uint8_t i = 0; i < 10 && !other.poll(); i++) {}
+  if (other.pending() || results.size() != 2 || results[0].error != DS3231_ERR_OTHER || results[1].error != DS3231_ERR_OTHER)
+    FAIL("refused: %u pending, %u callbacks, expected 2 with DS3231_ERR_OTHER", other.pending(), (unsigned) results.size());
+}
+
+int main() {
+  bus.attach(DS3231_ADDRESS, &sim);
+  rtc.begin(&bus);
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 4; dt.tm_mday = 3; dt.tm_hour = 10; dt.tm_min = 20; dt.tm_sec = 30;
+  dt.tm_wday = DS3231::weekDay(24, 4, 3);
+  rtc.adjust(dt);
+  sim.setTemperature(23.25f);
+  rtc.startConversion();
+  sim.advance(200000);
+  rtcAsync.begin(&transport);
+
+  testMerge();
+  testOrder();
+  testQueueFull();
+  testErrors();
+
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+// Two threads drive one DS3231Sim through two DS3231 objects sharing a bus
+// and a DS3231BusLock, while the main thread injects NAKs, timeouts and
+// clock stretching with TwoWire::failNext() and stallNext(). Checks that
+// every successful read returns the registers it asked for (the lock keeps
+// the transactions of the two threads apart) and that the retry, error and
+// lock counters of busStats() add up to the faults seen on the wire.
+//
+//   g++ -O2 -std=gnu++11 -pthread -Iextras/host -Isrc -o bus_race extras/host/tests/bus_race.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./bus_race
+// Add -fsanitize=thread to also check the stand-ins for data races.
+#include <DS3231.h>
+#include <DS3231Sim.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#define CALLS     50000   // per thread
+#define RETRIES   3
+
+// Polls a std::mutex until the timeout (ThreadSanitizer does not see the
+// std::timed_mutex waits)
+class MutexLock : public DS3231BusLock
+{
+public:
+  bool lock(uint32_t timeout_us) override {
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout_us);
+    while (!_mutex.try_lock()) {
+      if (std::chrono::steady_clock::now() > end)
+        return false;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+  void unlock(void) override { _mutex.unlock(); }
+
+private:
+  std::mutex _mutex;
+};
+
+static TwoWire bus;
+static DS3231Sim sim;
+static MutexLock busLock;
+static std::atomic<bool> running{true};
+static std::atomic<uint32_t> recoveries{0};
+static std::atomic<uint32_t> failures{0};
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+static void recover(void) { recoveries++; }
+
+typedef struct {
+  DS3231BusStats_t stats;
+  uint32_t ok;
+  uint32_t failed;
+} Result_t;
+
+// Reads the time, set once and never advanced
+static void timeReader(DS3231 *rtc, uint32_t expect, Result_t *result) {
+  for (uint32_t i = 0; i < CALLS; i++) {
+    uint32_t epoch = rtc->epochNow();
+    if (rtc->lastError() != DS3231_OK) {
+      result->failed++;
+      continue;
+    }
+    result->ok++;
+    if (epoch != expect)
+      FAIL("epochNow() %u, expected %u", epoch, expect);
+  }
+  result->stats = rtc->busStats();
+}
+
+// Reads the temperature and the aging offset, set once, and writes the
+// CONTROL register (the faults of a read end as DS3231_ERR_READ on the
+// stand-in, those of a write keep their code and call the recovery)
+static void registerReader(DS3231 *rtc, int8_t aging, Result_t *result) {
+  for (uint32_t i = 0; i < CALLS; i++) {
+    rtc->setSquareWaveRate(DS3231_SQW_OFF);
+    int16_t raw = rtc->getTemperatureRaw();
+    int8_t offset = rtc->getAgingOffset();
+    if (rtc->lastError() != DS3231_OK) {
+      result->failed++;
+      continue;
+    }
+    result->ok++;
+    if (raw != 25 * 4 || offset != aging)
+      FAIL("temperature %d aging %d, expected %d %d", raw, offset, 25 * 4, aging);
+  }
+  result->stats = rtc->busStats();
+}
+
+// Arms a fault whenever the previous one has been used
+static void injector(void) {
+  static const uint8_t errors[] = {2, 3, 4, 5};
+  uint32_t n = 0;
+  while (running) {
+    bus.failNext(1 + n % RETRIES, errors[n % 4]);
+    if (n % 8 == 0)
+      bus.stallNext(1, 200);
+    n++;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+int main() {
+  bus.attach(DS3231_ADDRESS, &sim);
+  sim.setTemperature(25.0f);
+  DS3231 rtc1, rtc2;
+  DS3231 *rtcs[] = {&rtc1, &rtc2};
+  for (DS3231 *rtc : rtcs) {
+    rtc->begin(&bus);
+    rtc->setBusLock(&busLock);
+    rtc->setRetries(RETRIES);
+    rtc->onBusRecovery(recover);
+  }
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 4; dt.tm_mday = 3; dt.tm_hour = 10; dt.tm_min = 20; dt.tm_sec = 30;
+  rtc1.adjust(dt);
+  rtc1.setAgingOffset(-7);
+  for (DS3231 *rtc : rtcs)
+    rtc->resetBusStats();
+  bus.resetStats();
+
+  Result_t r1{}, r2{};
+  std::thread faults(injector);
+  std::thread t1(timeReader, &rtc1, DS3231::toEpoch(dt), &r1);
+  std::thread t2(registerReader, &rtc2, -7, &r2);
+  t1.join();
+  t2.join();
+  running = false;
+  faults.join();
+
+  // every attempt is one transaction on the wire, a failed one is a retry
+  // or the last attempt of a failed transaction
+  const TwoWireStats_t &wire = bus.stats();
+  uint32_t transactions = 0, retries = 0, errors = 0, timeouts = 0, contended = 0, waited = 0, recovered = 0;
+  for (const Result_t *r : {&r1, &r2}) {
+    transactions += r->stats.transactions;
+    retries += r->stats.retries;
+    errors += r->stats.errors;
+    timeouts += r->stats.lock_timeouts;
+    contended += r->stats.contended;
+    if (r->stats.lock_wait_max > waited)
+      waited = r->stats.lock_wait_max;
+    recovered += r->stats.recoveries;
+  }
+  if (wire.transactions != transactions - timeouts + retries)
+    FAIL("%u transactions on the wire, %u by the drivers", wire.transactions, transactions - timeouts + retries);
+  if (wire.naks != retries + errors - timeouts)
+    FAIL("%u faults on the wire, %u retries + %u errors", wire.naks, retries, errors - timeouts);
+  if (recovered != recoveries || recovered == 0)
+    FAIL("%u recoveries counted, %u calls of the callback", recovered, (uint32_t) recoveries);
+  if (r1.failed + r2.failed == 0 && errors != 0)
+    FAIL("%u errors, no failed call", errors);
+  if (retries == 0 || contended == 0)
+    FAIL("%u retries and %u contended transactions, the faults or the race did not happen", retries, contended);
+
+  printf("%u calls ok, %u failed, %u transactions, %u retries, %u errors, %u lock timeouts\n",
+    r1.ok + r2.ok, r1.failed + r2.failed, transactions, retries, errors, timeouts);
+  printf("%u contended, longest lock wait %uus, %u faults on %u transactions on the wire, %u recoveries\n",
+    contended, waited, wire.naks, wire.transactions, (uint32_t) recoveries);
+  printf("%u failures\n", (uint32_t) failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+// DS3231Calibration on DS3231Sim with a crystal error, against a reference
+// read from the virtual time. Checks the offset measured by each sample
+// against the true offset of the model, the I2C transactions a sample takes
+// while it looks for the second boundary, the estimated error and the error
+// left once apply() has written the recommended aging offset.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o calibration extras/host/tests/calibration.cpp
+//     src/DS3231.cpp src/DS3231Calibration.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./calibration
+#include <DS3231Calibration.h>
+#include <DS3231Sim.h>
+#include <math.h>
+
+#define CRYSTAL_PPM   3.7f
+#define HOURS         48
+#define MAX_TX        100    // per sample
+#define MAX_ERROR_US  2500   // of the offset, two epochNow() of about 1ms at 100kHz
+
+static DS3231Sim sim;
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+static uint64_t virtualMicros(void) { return sim.micros(); }
+static void virtualDelay(uint64_t usec) { sim.advance(usec); }
+
+// True time, the virtual time since the RTC has been set
+class VirtualReference : public DS3231Reference
+{
+public:
+  uint32_t epoch{0};      // of the RTC when set
+  uint64_t set{0};        // sim.micros() when set
+  int64_t offset{0};      // true RTC - reference at the last read
+
+  bool read(uint32_t *ref_epoch, uint32_t *ref_usec) override {
+    uint64_t now = (uint64_t) epoch * 1000000ULL + (sim.micros() - set);
+    *ref_epoch = now / 1000000ULL;
+    *ref_usec = now % 1000000ULL;
+    DS3231Snapshot snap;
+    for (uint8_t i = 0; i < DS3231_REGISTERS; i++)
+      snap.reg[i] = sim.reg(i);
+    offset = (int64_t) DS3231::toEpoch(snap.now()) * 1000000LL + sim.phase() - (int64_t) now;
+    return true;
+  }
+};
+
+static TwoWire bus;
+static DS3231 rtc;
+static VirtualReference reference;
+static DS3231Calibration calibration;
+
+// One sample an hour, returns the most transactions taken by a sample
+static uint32_t measure(const char *when) {
+  uint32_t most = 0;
+  for (uint16_t h = 0; h <= HOURS; h++) {
+    uint32_t before = bus.stats().transactions;
+    if (!calibration.sample()) {
+      FAIL("%s: sample %u failed", when, h);
+      continue;
+    }
+    uint32_t tx = bus.stats().transactions - before;
+    if (tx > most)
+      most = tx;
+    if (tx > MAX_TX)
+      FAIL("%s: sample %u took %u transactions", when, h, tx);
+    if (llabs(calibration.offset() - reference.offset) > MAX_ERROR_US)
+      FAIL("%s: sample %u measured %d us, true offset %lld us", when, h, calibration.offset(), (long long) reference.offset);
+    sim.advance(3600000000ULL - 500000ULL * (h % 3));
+  }
+  return most;
+}
+
+int main() {
+  hostSetClock(virtualMicros, virtualDelay);
+  bus.attach(DS3231_ADDRESS, &sim);
+  rtc.begin(&bus);
+  sim.setCrystalError(CRYSTAL_PPM);
+  sim.setTemperature(25.0f);
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 3; dt.tm_mday = 1;
+  dt.tm_wday = DS3231::weekDay(24, 3, 1);
+  rtc.adjust(dt);
+  reference.epoch = DS3231::toEpoch(dt);
+  reference.set = sim.micros();
+  sim.advance(400000);
+  calibration.begin(&rtc, &reference);
+
+  uint32_t most = measure("before apply()");
+  float before = calibration.ppm();
+  if (fabsf(before - CRYSTAL_PPM) > 0.05f)
+    FAIL("estimated %.3f ppm, crystal %.3f ppm", before, CRYSTAL_PPM);
+  int8_t aging = calibration.recommended();
+  if (calibration.recommended(40.0f) != aging)
+    FAIL("recommended(40) %d differs from recommended() %d at a single temperature", calibration.recommended(40.0f), aging);
+  if (!calibration.apply() || rtc.getAgingOffset() != aging)
+    FAIL("apply() did not write the aging offset %d", aging);
+
+  float w = calibration.state().w;
+  uint32_t after = measure("after apply()");
+  if (after > most)
+    most = after;
+  // the fit keeps the first measurements, corrected for the new offset
+  float residual = sim.frequencyError();
+  if (fabsf(residual) > DS3231_CALIBRATION_PPM_LSB)
+    FAIL("%.3f ppm left with the aging offset %d", residual, aging);
+  if (fabsf(calibration.ppm() - residual) > 0.05f || calibration.state().w <= w)
+    FAIL("estimated %.3f ppm after apply(), %.3f ppm left", calibration.ppm(), residual);
+  hostSetClock(nullptr, nullptr);
+
+  printf("estimated %.3f ppm of %.3f ppm, aging offset %d, %.3f ppm left, at most %u transactions per sample\n",
+    before, CRYSTAL_PPM, aging, residual, most);
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+// DS3231Clock on DS3231Sim with tick() called by the 1Hz SQW edges of the
+// model. Checks nowFast() before the clock is synchronised, the time and
+// microseconds it returns against the registers and the phase of the model
+// without a transaction on the bus, verify() after missed and extra edges,
+// and ppm() against a crystal error of the model.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o clock extras/host/tests/clock.cpp
+//     src/DS3231.cpp src/DS3231Clock.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./clock
+#include <DS3231Clock.h>
+#include <DS3231Sim.h>
+#include <stdlib.h>
+
+#define MAX_USEC_ERROR 2  // of the microseconds, the truncation of micros() and of the model
+
+static DS3231Sim sim;
+static TwoWire bus;
+static DS3231 rtc;
+static DS3231Clock swClock;
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+static uint64_t virtualMicros(void) { return sim.micros(); }
+static void virtualDelay(uint64_t usec) { sim.advance(usec); }
+static void edge(void) { swClock.tick(); }
+
+// Time of the chip read from the model, not counted on the bus
+static uint32_t chipTime(void) {
+  DS3231Snapshot snap{};
+  for (uint8_t i = 0; i < DS3231_REGISTERS; i++)
+    snap.reg[i] = sim.reg(i);
+  return DS3231::toEpoch(snap.now());
+}
+
+static void testUnsynced(void) {
+  swClock.begin(&rtc);
+  if (sim.reg(DS3231_CONTROL) & (1 << DS3231_CONTROL_INTCON) || (sim.reg(DS3231_CONTROL) & DS3231_SQW_OFF) != DS3231_SQW_1HZ)
+    FAIL("begin(): SQW not set to 1Hz, CONTROL %02x", sim.reg(DS3231_CONTROL));
+
+  // no edge yet, nothing to synchronise to
+  uint32_t before = bus.stats().transactions;
+  uint32_t usec = 12345;
+  if (swClock.nowFast(&usec) != 0 || usec != 0 || swClock.isSynced())
+    FAIL("nowFast() before the first edge: %u.%06u", swClock.nowFast(), usec);
+  if (swClock.update() || swClock.verify() != 0 || bus.stats().transactions != before)
+    FAIL("update()/verify() before the first edge: synced or %u transactions", bus.stats().transactions - before);
+
+  // edges counted but not synchronised yet
+  sim.advance(3500000);
+  if (swClock.nowFast(&usec) != 0 || usec != 0)
+    FAIL("nowFast() after 3 edges before update(): %u.%06u", swClock.nowFast(), usec);
+  if (!swClock.update() || swClock.nowFast() != chipTime())
+    FAIL("update(): nowFast() %u, chip %u", swClock.nowFast(), chipTime());
+}
+
+static void testNowFast(void) {
+  srand(3231);
+  uint32_t before = bus.stats().transactions;
+  for (uint16_t i = 0; i < 5000; i++) {
+    sim.advance(1 + rand() % 700000);
+    uint32_t usec;
+    uint32_t seconds = swClock.nowFast(&usec);
+    if (seconds != chipTime() || abs((int32_t) usec - (int32_t) sim.phase()) > MAX_USEC_ERROR)
+      FAIL("nowFast() %u.%06u, chip %u.%06u", seconds, usec, chipTime(), sim.phase());
+  }
+  if (bus.stats().transactions != before)
+    FAIL("nowFast(): %u transactions", bus.stats().transactions - before);
+  if (swClock.update() != true || bus.stats().transactions != before)
+    FAIL("update() once synchronised: %u transactions", bus.stats().transactions - before);
+}
+
+static void testVerify(void) {
+  sim.advance(300000);
+  if (swClock.verify() != 0)
+    FAIL("verify() of a consistent clock");
+
+  // the interrupt disabled for 3 edges
+  sim.onInterrupt(nullptr);
+  sim.advance(3000000);
+  sim.onInterrupt(edge);
+  if (swClock.nowFast() != chipTime() - 3)
+    FAIL("missed edges: nowFast() %u, chip %u, expected 3s behind", swClock.nowFast(), chipTime());
+  int32_t drift = swClock.verify();
+  if (drift != 3 || swClock.nowFast() != chipTime())
+    FAIL("missed edges: verify() %d, nowFast() %u, chip %u", drift, swClock.nowFast(), chipTime());
+
+  // a glitch counted as an edge
+  swClock.tick();
+  drift = swClock.verify();
+  if (drift != -1 || swClock.nowFast() != chipTime())
+    FAIL("extra edge: verify() %d, nowFast() %u, chip %u", drift, swClock.nowFast(), chipTime());
+  if (swClock.verify() != 0)
+    FAIL("verify() after the re-synchronisation");
+
+  // the time set again on the chip
+  DateTime dt{};
+  dt.tm_year = 31; dt.tm_mon = 12; dt.tm_mday = 31; dt.tm_hour = 23; dt.tm_min = 59; dt.tm_sec = 50;
+  dt.tm_wday = DS3231::weekDay(31, 12, 31);
+  rtc.adjust(dt);
+  sim.advance(1200000);
+  uint32_t fast = swClock.nowFast();
+  drift = swClock.verify();
+  if (drift != static_cast<int32_t>(chipTime() - fast) || swClock.nowFast() != chipTime())
+    FAIL("adjust(): verify() %d, nowFast() %u, chip %u", drift, swClock.nowFast(), chipTime());
+}
+
+static void testPpm(void) {
+  sim.setCrystalError(20.0f);  // the RTC runs fast, so micros() runs slow against it
+  sim.advance(3000000);
+  int32_t ppm = swClock.ppm();
+  if (abs(ppm + 20) > 1)
+    FAIL("ppm() %d with the RTC 20ppm fast, expected -20", ppm);
+  sim.setCrystalError(-35.0f);
+  sim.advance(3000000);
+  ppm = swClock.ppm();
+  if (abs(ppm - 35) > 1)
+    FAIL("ppm() %d with the RTC 35ppm slow, expected 35", ppm);
+  sim.setCrystalError(0.0f);
+}
+
+int main() {
+  hostSetClock(virtualMicros, virtualDelay);
+  bus.attach(DS3231_ADDRESS, &sim);
+  sim.onInterrupt(edge);
+  rtc.begin(&bus);
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 4; dt.tm_mday = 3; dt.tm_hour = 10; dt.tm_min = 20; dt.tm_sec = 30;
+  dt.tm_wday = DS3231::weekDay(24, 4, 3);
+  rtc.adjust(dt);
+
+  testUnsynced();
+  testNowFast();
+  testVerify();
+  testPpm();
+  hostSetClock(nullptr, nullptr);
+
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
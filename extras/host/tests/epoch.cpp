@@ -0,0 +1,114 @@
+// Exhaustive check of the date/time conversions against the C library
+// (time.h with a 64-bit time_t) for every day of 2000 - 2199, at the first
+// and the last second of the day, and a benchmark of the conversions.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o epoch extras/host/tests/epoch.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp && ./epoch
+#include <DS3231.h>
+#include <time.h>
+#include <chrono>
+
+static_assert(sizeof(time_t) >= 8, "needs a 64-bit time_t");
+
+#define UNIX_2000   946684800LL
+#define EPOCH_MAX   0xFFFFFFFFLL   // toEpoch()/fromEpoch() until 2136
+#define UNIX_MAX    0xFFFFFFFFLL   // toUnix()/fromUnix() until 2106
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...) do { \
+  if (!(cond)) { \
+    if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+  } \
+} while (0)
+
+static bool same(const DateTime &dt, const struct tm &ref) {
+  return dt.tm_year == ref.tm_year - 100 && dt.tm_mon == ref.tm_mon + 1 && dt.tm_mday == ref.tm_mday &&
+         dt.tm_hour == ref.tm_hour && dt.tm_min == ref.tm_min && dt.tm_sec == ref.tm_sec &&
+         dt.tm_wday == ref.tm_wday && dt.tm_yday == ref.tm_yday;
+}
+
+static DateTime fromTm(const struct tm &ref) {
+  DateTime dt{};
+  dt.tm_year = ref.tm_year - 100;
+  dt.tm_mon = ref.tm_mon + 1;
+  dt.tm_mday = ref.tm_mday;
+  dt.tm_hour = ref.tm_hour;
+  dt.tm_min = ref.tm_min;
+  dt.tm_sec = ref.tm_sec;
+  return dt;
+}
+
+static void checkSecond(int64_t seconds, int64_t last) {
+  time_t t = UNIX_2000 + seconds;
+  struct tm ref;
+  gmtime_r(&t, &ref);
+  DateTime dt = fromTm(ref);
+
+  CHECK(DS3231::weekDay(dt.tm_year, dt.tm_mon, dt.tm_mday) == ref.tm_wday, "weekDay %lld", (long long) seconds);
+  CHECK(DS3231::dayOfYear(dt.tm_year, dt.tm_mon, dt.tm_mday) == ref.tm_yday, "dayOfYear %lld", (long long) seconds);
+  if (seconds <= EPOCH_MAX) {
+    CHECK(DS3231::toEpoch(dt) == seconds, "toEpoch %lld", (long long) seconds);
+    DateTime back{};
+    DS3231::fromEpoch(static_cast<uint32_t>(seconds), &back);
+    CHECK(same(back, ref), "fromEpoch %lld", (long long) seconds);
+  }
+  if (t <= UNIX_MAX) {
+    CHECK(DS3231::toUnix(dt) == t, "toUnix %lld", (long long) t);
+    DateTime back{};
+    DS3231::fromUnix(static_cast<uint32_t>(t), &back);
+    CHECK(same(back, ref), "fromUnix %lld", (long long) t);
+  }
+
+  // durations to both sides, kept within 2000 - 2199
+  static const int32_t steps[] = {1, 59, 3600, 86399, 86400, 2678400, 31622400, 1000000007L, INT32_MAX};
+  for (int32_t step : steps) {
+    for (int sign = -1; sign <= 1; sign += 2) {
+      int64_t target = seconds + sign * static_cast<int64_t>(step);
+      if (target < 0 || target > last)
+        continue;
+      time_t tt = UNIX_2000 + target;
+      struct tm expect;
+      gmtime_r(&tt, &expect);
+      DateTime moved = dt;
+      DS3231::addSeconds(&moved, static_cast<int32_t>(sign * static_cast<int64_t>(step)));
+      CHECK(same(moved, expect), "addSeconds %lld %+lld", (long long) seconds, (long long) (sign * static_cast<int64_t>(step)));
+      DateTime other = fromTm(expect);
+      CHECK(DS3231::diffSeconds(other, dt) == target - seconds, "diffSeconds %lld %lld", (long long) target, (long long) seconds);
+    }
+  }
+}
+
+template <typename F>
+static double nsPerCall(uint32_t n, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; i++)
+    f(i);
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+}
+
+int main() {
+  struct tm end{};
+  end.tm_year = 300;  // 2200/01/01
+  end.tm_mday = 1;
+  int64_t last = timegm(&end) - UNIX_2000 - 1;  // 2199/12/31 23:59:59
+
+  uint32_t days = 0;
+  for (int64_t day = 0; day * 86400 <= last; day++, days++) {
+    checkSecond(day * 86400, last);
+    checkSecond(day * 86400 + 86399, last);
+  }
+  printf("%u days of 2000 - 2199 checked, %u failures\n", days, failures);
+
+  // benchmark, the sum keeps the calls from being optimised out
+  volatile uint32_t sink = 0;
+  DateTime dt{};
+  double from = nsPerCall(10000000, [&](uint32_t i) { DS3231::fromEpoch(i * 431, &dt); sink += dt.tm_mday; });
+  double fromRef = nsPerCall(10000000, [&](uint32_t i) { time_t t = UNIX_2000 + i * 431; struct tm r; gmtime_r(&t, &r); sink += r.tm_mday; });
+  double to = nsPerCall(10000000, [&](uint32_t i) { dt.tm_mday = 1 + i % 28; sink += DS3231::toEpoch(dt); });
+  double toRef = nsPerCall(10000000, [&](uint32_t i) { struct tm r{}; r.tm_year = 124; r.tm_mday = 1 + i % 28; sink += timegm(&r); });
+  double wday = nsPerCall(10000000, [&](uint32_t i) { sink += DS3231::weekDay(i % 200, 1 + i % 12, 1 + i % 28); });
+  printf("fromEpoch %.1f ns (gmtime_r %.1f ns), toEpoch %.1f ns (timegm %.1f ns), weekDay %.1f ns\n",
+    from, fromRef, to, toRef, wday);
+  return failures ? 1 : 0;
+}
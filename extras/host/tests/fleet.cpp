@@ -0,0 +1,144 @@
+// DS3231Fleet on two buses: two TCA9548A on the first bus, one on the
+// second, one DS3231Sim per channel. Checks that every reading comes from
+// its device, that no two channels of a bus are ever enabled together, the
+// transactions per sweep (a multiplexer is only disabled for another one of
+// the same bus) and the recovery after a NAK of a multiplexer.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o fleet extras/host/tests/fleet.cpp
+//     src/DS3231.cpp src/DS3231Fleet.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./fleet
+#include <DS3231Fleet.h>
+#include <DS3231Sim.h>
+
+#define CHANNELS 8
+
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+// TCA9548A: one control register, a bit per channel
+class Mux : public TwoWireDevice
+{
+public:
+  uint8_t channels{0};
+  bool onWrite(const uint8_t *data, size_t len) override { channels = data[len - 1]; return true; }
+  bool onRead(uint8_t *data, size_t len) override { memset(data, channels, len); return true; }
+};
+
+// The DS3231 at 0x68 behind the enabled channels of a bus
+class Bus : public TwoWireDevice
+{
+public:
+  TwoWire wire;
+  Mux muxes[2];
+  DS3231Sim sims[2][CHANNELS];
+  uint8_t count;
+  uint32_t conflicts{0};
+
+  Bus(uint8_t muxCount) : count(muxCount) {
+    for (uint8_t m = 0; m < count; m++)
+      wire.attach(0x70 + m, &muxes[m]);
+    wire.attach(DS3231_ADDRESS, this);
+  }
+  bool onWrite(const uint8_t *data, size_t len) override { DS3231Sim *s = _target(); return s && s->onWrite(data, len); }
+  bool onRead(uint8_t *data, size_t len) override { DS3231Sim *s = _target(); return s && s->onRead(data, len); }
+
+private:
+  DS3231Sim *_target(void) {
+    DS3231Sim *target = nullptr;
+    uint8_t enabled = 0;
+    for (uint8_t m = 0; m < count; m++) {
+      for (uint8_t c = 0; c < CHANNELS; c++) {
+        if (muxes[m].channels & (1 << c)) {
+          target = &sims[m][c];
+          enabled++;
+        }
+      }
+    }
+    if (enabled > 1)
+      conflicts++;
+    return target;
+  }
+};
+
+static Bus busA(2), busB(1);
+static DS3231Fleet<32> fleet;
+static int16_t ids[2][2][CHANNELS];
+
+// The temperature register of each device holds its position
+static int16_t tag(uint8_t bus, uint8_t mux, uint8_t channel) {
+  return bus * 32 + mux * CHANNELS + channel;
+}
+
+static uint32_t transactions(void) {
+  return busA.wire.stats().transactions + busB.wire.stats().transactions;
+}
+
+static void sweep(void) {
+  uint32_t n = fleet.sweeps();
+  while (fleet.sweeps() == n)
+    fleet.poll();
+}
+
+static void checkReadings(const char *when) {
+  Bus *buses[] = {&busA, &busB};
+  for (uint8_t b = 0; b < 2; b++) {
+    for (uint8_t m = 0; m < buses[b]->count; m++) {
+      for (uint8_t c = 0; c < CHANNELS; c++) {
+        const DS3231Reading_t &r = fleet.reading(ids[b][m][c]);
+        if (r.error || r.snap.temperatureRaw() != tag(b, m, c) * 4)
+          FAIL("%s: bus %u mux %u channel %u error %02x temperature %d", when, b, m, c, r.error, r.snap.temperatureRaw() / 4);
+      }
+    }
+  }
+}
+
+int main() {
+  Bus *buses[] = {&busA, &busB};
+  fleet.begin(DS3231_TEMPERATURE, 2);
+  fleet.setBudget(5);
+  for (uint8_t b = 0; b < 2; b++) {
+    for (uint8_t m = 0; m < buses[b]->count; m++) {
+      for (uint8_t c = 0; c < CHANNELS; c++) {
+        buses[b]->sims[m][c].setTemperature(tag(b, m, c));
+        buses[b]->sims[m][c].setReg(DS3231_TEMPERATURE, tag(b, m, c));
+        ids[b][m][c] = fleet.add(&buses[b]->wire, 0x70 + m, c);
+      }
+    }
+  }
+
+  // first sweep from the power-on state, then the steady state: one read
+  // and one selection per device, one deselection per multiplexer of the
+  // first bus, none when going from a bus to the other
+  sweep();
+  checkReadings("first sweep");
+  uint32_t before = transactions();
+  sweep();
+  uint32_t perSweep = transactions() - before;
+  uint32_t devices = (busA.count + busB.count) * CHANNELS;
+  if (perSweep != devices * 2 + busA.count)
+    FAIL("%u transactions per sweep, expected %u", perSweep, devices * 2 + busA.count);
+  checkReadings("steady state");
+
+  // a NAK of each multiplexer in turn, the device fails once and the next
+  // sweep is clean
+  for (uint8_t b = 0; b < 2; b++) {
+    for (uint8_t i = 0; i < 8; i++) {
+      buses[b]->wire.failNext(1);
+      sweep();
+      if (fleet.failed() != 1)
+        FAIL("NAK %u on bus %u: %u devices failed", i, b, fleet.failed());
+      sweep();
+      checkReadings("after a NAK");
+    }
+  }
+  if (busA.conflicts || busB.conflicts)
+    FAIL("%u and %u reads with two channels enabled", busA.conflicts, busB.conflicts);
+
+  printf("%u devices on 2 buses, %u transactions per sweep, %u sweeps, %u channel switches\n",
+    devices, perSweep, fleet.sweeps(), fleet.switches());
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+// DS3231 through LinuxWire over LinuxI2CSim, without hardware. Records the
+// I2C_RDWR ioctls and checks that a register read is one ioctl with a write
+// and a read message, that the writes between beginBatch() and endBatch()
+// (or the next read) go out in a single ioctl, and that the errno of a
+// failed ioctl maps to the error codes of the driver and is retried.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o linuxwire extras/host/tests/linuxwire.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/LinuxWire.cpp extras/host/DS3231Sim.cpp
+//   ./linuxwire
+#include <DS3231.h>
+#include <DS3231Sim.h>
+#include <LinuxWire.h>
+#include <errno.h>
+
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+// Keeps the messages of the last ioctl, fails the next ones with an errno
+class RecordingI2C : public LinuxI2CSim
+{
+public:
+  uint32_t nmsgs{0};
+  struct i2c_msg msgs[LINUXWIRE_BATCH + 2];
+  int fail{0};  // errno of the next ioctl, 0 to pass it to the model
+
+  int ioctl(int fd, unsigned long request, void *arg) override {
+    struct i2c_rdwr_ioctl_data *data = static_cast<struct i2c_rdwr_ioctl_data *>(arg);
+    nmsgs = data->nmsgs;
+    memcpy(msgs, data->msgs, data->nmsgs * sizeof(struct i2c_msg));
+    if (fail) {
+      errno = fail;
+      fail = 0;
+      return -1;
+    }
+    return LinuxI2CSim::ioctl(fd, request, arg);
+  }
+};
+
+static RecordingI2C i2c;
+static DS3231Sim sim;
+static LinuxWire bus(&i2c);
+static DS3231 rtc;
+
+static void expectCalls(const char *what, uint32_t before, uint32_t calls, uint32_t nmsgs) {
+  if (bus.syscalls() - before != calls || i2c.nmsgs != nmsgs)
+    FAIL("%s: %u ioctls of %u messages, expected %u of %u", what, bus.syscalls() - before, i2c.nmsgs, calls, nmsgs);
+}
+
+static void testRead(void) {
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 2; dt.tm_mday = 29; dt.tm_hour = 23; dt.tm_min = 59; dt.tm_sec = 58;
+  rtc.adjust(dt);
+  uint32_t expect = DS3231::toEpoch(dt);
+
+  uint32_t before = bus.syscalls();
+  uint32_t epoch = rtc.epochNow();
+  expectCalls("epochNow()", before, 1, 2);
+  const struct i2c_msg *m = i2c.msgs;
+  if (m[0].addr != DS3231_ADDRESS || m[0].flags != 0 || m[0].len != 1 || m[0].buf[0] != DS3231_TIME)
+    FAIL("epochNow(): first message addr %02x flags %x len %u, expected the write of the register address", m[0].addr, m[0].flags, m[0].len);
+  if (m[1].addr != DS3231_ADDRESS || m[1].flags != I2C_M_RD || m[1].len != 7)
+    FAIL("epochNow(): second message addr %02x flags %x len %u, expected a read of 7 bytes", m[1].addr, m[1].flags, m[1].len);
+  if (epoch != expect || rtc.lastError() != DS3231_OK)
+    FAIL("epochNow() %u error %u, expected %u", epoch, rtc.lastError(), expect);
+
+  before = bus.syscalls();
+  DS3231Snapshot snap = rtc.snapshot();
+  expectCalls("snapshot()", before, 1, 2);
+  if (DS3231::toEpoch(snap.now()) != expect)
+    FAIL("snapshot() time %u, expected %u", DS3231::toEpoch(snap.now()), expect);
+}
+
+static void testBatch(void) {
+  rtc.enableShadow();  // the writes below then read nothing
+  DateTime dt{};
+  dt.tm_year = 30; dt.tm_mon = 7; dt.tm_mday = 4; dt.tm_hour = 12;
+
+  uint32_t before = bus.syscalls();
+  bus.beginBatch();
+  rtc.setAlarm1(&dt, DS3231_ALARM1_ON_DATE);
+  rtc.setSquareWaveRate(DS3231_SQW_OFF);
+  rtc.disable32K();
+  if (bus.syscalls() != before)
+    FAIL("batch: %u ioctls before endBatch()", bus.syscalls() - before);
+  if (bus.endBatch() != 0)
+    FAIL("batch: endBatch() failed");
+  expectCalls("batch of 3 writes", before, 1, 3);
+  DateTime alarm{};
+  if (rtc.getAlarm1Status(&alarm) != DS3231_ALARM1_ON_DATE || alarm.tm_mday != 4 || alarm.tm_hour != 12)
+    FAIL("batch: Alarm 1 not written");
+
+  // the queued writes go out with the next read: adjust() writes the time
+  // and STATUS (OSF cleared from the shadow)
+  before = bus.syscalls();
+  bus.beginBatch();
+  rtc.adjust(dt);
+  int16_t raw = rtc.getTemperatureRaw();
+  expectCalls("batch ended by a read", before, 1, 4);
+  if (bus.endBatch() != 0 || bus.syscalls() - before != 1)
+    FAIL("batch: %u ioctls after an empty endBatch()", bus.syscalls() - before);
+  if (rtc.epochNow() != DS3231::toEpoch(dt) || raw != sim.reg(DS3231_TEMPERATURE) * 4)
+    FAIL("batch: adjust() not written or temperature %d wrong", raw);
+  rtc.disableShadow();
+}
+
+// Writes report the error of the ioctl, reads only a short read (the
+// Arduino API of requestFrom() has no error code)
+static void testErrors(void) {
+  rtc.lastError();
+  rtc.setRetries(0);
+  static const struct {
+    int error;
+    DS3231_ERROR_t expect;
+  } cases[] = {{ENXIO, DS3231_ERR_NACK_ADDRESS}, {EREMOTEIO, DS3231_ERR_NACK_ADDRESS}, {EIO, DS3231_ERR_OTHER}};
+  for (const auto &c : cases) {
+    i2c.fail = c.error;
+    rtc.setAgingOffset(1);  // the write fails, the read back passes
+    DS3231_ERROR_t err = rtc.lastError();
+    if (err != c.expect)
+      FAIL("errno %d on a write: error %u, expected %u", c.error, err, c.expect);
+  }
+  i2c.fail = ENXIO;
+  rtc.epochNow();
+  if (rtc.lastError() != DS3231_ERR_READ)
+    FAIL("ENXIO on a read: error %u, expected DS3231_ERR_READ", rtc.lastError());
+
+  // a failed ioctl is retried
+  rtc.setRetries(1);
+  i2c.fail = ENXIO;
+  uint32_t before = bus.syscalls();
+  uint32_t epoch = rtc.epochNow();
+  if (rtc.lastError() != DS3231_OK || bus.syscalls() - before != 2 || epoch == 0)
+    FAIL("retry: error after %u ioctls", bus.syscalls() - before);
+
+  // no device at the address, the model NAKs it
+  LinuxI2CSim empty;
+  LinuxWire other(&empty);
+  DS3231 absent;
+  absent.begin(&other);
+  absent.setRetries(0);
+  absent.lastError();
+  absent.setAgingOffset(0);
+  if (absent.lastError() != DS3231_ERR_NACK_ADDRESS)
+    FAIL("no device: error %u, expected DS3231_ERR_NACK_ADDRESS", absent.lastError());
+}
+
+int main() {
+  i2c.attach(DS3231_ADDRESS, &sim);
+  if (!rtc.begin(&bus))
+    FAIL("begin() failed");
+  testRead();
+  testBatch();
+  testErrors();
+
+  printf("%u ioctls\n", bus.syscalls());
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
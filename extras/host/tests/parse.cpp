@@ -0,0 +1,145 @@
+// Check of DS3231::parse(), DS3231::format(), both getDateTime() and the
+// compile-time DS3231_BUILD_EPOCH, and a benchmark of parse() against the
+// strtok()/atoi() parser it replaced.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o parse extras/host/tests/parse.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp && ./parse
+#include <DS3231.h>
+#include <chrono>
+
+static_assert(ds3231_build_epoch("Jan  1 2000", "00:00:00") == 0, "build epoch of 2000");
+static_assert(ds3231_build_epoch("Mar  1 2000", "00:00:01") == 60 * 86400UL + 1, "build epoch after a leap day");
+static_assert(ds3231_build_epoch("Dec 31 2024", "23:59:59") == 789004799UL, "build epoch of December");
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...) do { \
+  if (!(cond)) { \
+    failures++; \
+    printf(__VA_ARGS__); \
+    printf("\n"); \
+  } \
+} while (0)
+
+// The parser of the library before DS3231::parse(), modifies the text
+static void strtokParse(char *ts, DateTime *dt) {
+  dt->tm_year = atoi(strtok(ts, "/: ")) - 2000;
+  dt->tm_mon = atoi(strtok(NULL, "/: "));
+  dt->tm_mday = atoi(strtok(NULL, "/: "));
+  dt->tm_hour = atoi(strtok(NULL, "/: "));
+  dt->tm_min = atoi(strtok(NULL, "/: "));
+  dt->tm_sec = atoi(strtok(NULL, "/: "));
+  dt->tm_wday = DS3231::weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday);
+}
+
+static const struct {
+  const char *text;
+  const char *iso;  // nullptr when parse() fails
+} cases[] = {
+  {"2024/04/02 12:08:00", "2024-04-02T12:08:00"},
+  {"2024-04-02T12:08:00", "2024-04-02T12:08:00"},
+  {"2024-04-02T12:08", "2024-04-02T12:08:00"},
+  {"2024-04-02", "2024-04-02T00:00:00"},
+  {"2024/4/2 9:8:0", "2024-04-02T09:08:00"},
+  {"2024-04-02T12:08:00.123Z", "2024-04-02T12:08:00"},
+  {"2024-04-02T12:08:00+02:00", "2024-04-02T10:08:00"},
+  {"2024-04-02T23:08:00-0130", "2024-04-03T00:38:00"},
+  {"2024-02-29T00:00:00\r\n", "2024-02-29T00:00:00"},
+  {"2024-12-31", "2024-12-31T00:00:00"},
+  {"2150-06-01T12:00:00+01:00", "2150-06-01T11:00:00"},   // zone after the uint32_t epoch
+  {"2100-03-01T00:30:00+01:00", "2100-02-28T23:30:00"},   // 2100 is not a leap year
+  {"2199-12-31T23:59:59", "2199-12-31T23:59:59"},
+  {"2199-12-31T23:30:00+01:00", "2199-12-31T22:30:00"},
+  {"2199-12-31T23:30:00-01:00", nullptr},                 // 2200 in UTC
+  {"2000-01-01T00:00:00+01:00", nullptr},                 // 1999 in UTC
+  {"2000-01-01T00:30:00-01:00", "2000-01-01T01:30:00"},
+  {"2023-02-29T00:00:00", nullptr},
+  {"2100-02-29", nullptr},
+  {"2024-12-32", nullptr},
+  {"2024-13-01", nullptr},
+  {"1999-01-01", nullptr},
+  {"2200-01-01", nullptr},
+  {"2024-04-02T24:00", nullptr},
+  {"2024-04-02x", nullptr},
+  {"2024/04-02", nullptr},
+  {"24-04-02", nullptr},
+  {"", nullptr},
+  {"2024-04-02T12", nullptr},
+};
+
+int main() {
+  for (const auto &c : cases) {
+    DateTime dt{};
+    dt.tm_year = 77;
+    bool ok = DS3231::parse(c.text, strlen(c.text), &dt);
+    char iso[DS3231_FORMAT_SIZE] = "";
+    if (ok)
+      DS3231::format(iso, sizeof(iso), dt);
+    if (c.iso) {
+      CHECK(ok && strcmp(iso, c.iso) == 0, "parse(\"%s\") = %s, expected %s", c.text, ok ? iso : "false", c.iso);
+      CHECK(!ok || dt.tm_wday == DS3231::weekDay(dt.tm_year, dt.tm_mon, dt.tm_mday), "tm_wday of \"%s\"", c.text);
+    }
+    else {
+      CHECK(!ok && dt.tm_year == 77, "parse(\"%s\") = %s, expected false and unchanged", c.text, ok ? iso : "false");
+    }
+  }
+
+  // the length bounds the text, which is not modified
+  const char line[] = "2024-04-02T12:08:00GARBAGE";
+  DateTime dt{};
+  CHECK(DS3231::parse(line, 19, &dt), "parse() of the first 19 characters");
+  char ts[] = "2024/04/02 12:08:00";
+  CHECK(DS3231::getDateTime(ts, &dt) && strcmp(ts, "2024/04/02 12:08:00") == 0, "getDateTime() keeps the text");
+
+  // __DATE__ / __TIME__ of every month
+  static const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  for (uint8_t m = 1; m <= 12; m++) {
+    char date[12];
+    snprintf(date, sizeof(date), "%s %2d 2024", months[m - 1], 9);
+    DS3231::getDateTime(date, "13:45:07", &dt);
+    CHECK(dt.tm_year == 24 && dt.tm_mon == m && dt.tm_mday == 9 && dt.tm_hour == 13 && dt.tm_min == 45 && dt.tm_sec == 7,
+      "getDateTime(\"%s\")", date);
+  }
+
+  // formats, and a buffer too small
+  char buf[DS3231_FORMAT_SIZE];
+  DS3231::parse("2024-04-02T12:08:09", 19, &dt);
+  static const char *formats[] = {"2024-04-02T12:08:09", "2024/04/02 12:08:09", "2024-04-02", "12:08:09"};
+  for (uint8_t f = 0; f < 4; f++) {
+    uint8_t n = DS3231::format(buf, sizeof(buf), dt, static_cast<DS3231_FORMAT_t>(f));
+    CHECK(n == strlen(formats[f]) && strcmp(buf, formats[f]) == 0, "format %u: %s", f, buf);
+  }
+  CHECK(DS3231::format(buf, 19, dt) == 0 && buf[0] == '\0', "format() into a short buffer");
+
+  // benchmark
+  const uint32_t n = 2000000;
+  volatile uint32_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; i++) {
+    char text[] = "2024/04/02 12:08:00";
+    text[18] = '0' + i % 10;
+    DateTime d;
+    strtokParse(text, &d);
+    sink += d.tm_sec;
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; i++) {
+    char text[] = "2024/04/02 12:08:00";
+    text[18] = '0' + i % 10;
+    DateTime d;
+    DS3231::parse(text, 19, &d);
+    sink += d.tm_sec;
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < n; i++) {
+    dt.tm_sec = i % 60;
+    sink += DS3231::format(buf, sizeof(buf), dt);
+  }
+  auto t3 = std::chrono::steady_clock::now();
+  printf("%u cases, %u failures\n", (unsigned) (sizeof(cases) / sizeof(cases[0])), failures);
+  printf("strtok/atoi %.1f ns, parse() %.1f ns, format() %.1f ns\n",
+    std::chrono::duration<double, std::nano>(t1 - t0).count() / n,
+    std::chrono::duration<double, std::nano>(t2 - t1).count() / n,
+    std::chrono::duration<double, std::nano>(t3 - t2).count() / n);
+  return failures ? 1 : 0;
+}
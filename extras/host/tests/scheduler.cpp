@@ -0,0 +1,238 @@
+// DS3231Scheduler on DS3231Sim: the MCU sleeps until the INT pin with
+// advanceUntilInterrupt() and calls service(). Checks at(), every() with an
+// offset, cancel() of the next due alarm and of one inside the heap, the
+// reuse of the freed ids, alarms more than a month away (the ON_DATE alarm
+// also matches the same day of the current month, service() must not call
+// the task then) and random schedules against a sorted reference.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o scheduler extras/host/tests/scheduler.cpp
+//     src/DS3231.cpp src/DS3231Scheduler.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./scheduler
+#include <DS3231Scheduler.h>
+#include <DS3231Sim.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#define CAPACITY 16
+
+static DS3231Sim sim;
+static TwoWire bus;
+static DS3231 rtc;
+static DS3231Scheduler<CAPACITY> scheduler;
+static uint32_t failures = 0;
+static uint32_t wakes = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+static uint64_t virtualMicros(void) { return sim.micros(); }
+static void virtualDelay(uint64_t usec) { sim.advance(usec); }
+
+typedef struct {
+  uint8_t id;
+  uint32_t time;
+} Call_t;
+
+static std::vector<Call_t> calls;
+
+// Time of the chip read from the model, not counted on the bus
+static uint32_t chipTime(void) {
+  DS3231Snapshot snap;
+  for (uint8_t i = 0; i < DS3231_REGISTERS; i++)
+    snap.reg[i] = sim.reg(i);
+  return DS3231::toEpoch(snap.now());
+}
+
+static void task(uint8_t id) {
+  calls.push_back(Call_t{id, chipTime()});
+}
+
+// Sleeps from alarm to alarm until the end
+static void runUntil(uint32_t end) {
+  while (chipTime() < end) {
+    sim.advanceUntilInterrupt((uint64_t) (end - chipTime()) * 1000000ULL);
+    if (sim.intLow()) {
+      wakes++;
+      scheduler.service();
+    }
+  }
+}
+
+static void expectCalls(const char *what, const std::vector<Call_t> &expect) {
+  bool same = calls.size() == expect.size();
+  for (size_t i = 0; same && i < calls.size(); i++)
+    same = calls[i].id == expect[i].id && calls[i].time == expect[i].time;
+  if (!same) {
+    FAIL("%s: %u calls, expected %u", what, (unsigned) calls.size(), (unsigned) expect.size());
+    for (size_t i = 0; i < calls.size() && i < 8; i++)
+      printf("  called %u at %u\n", calls[i].id, calls[i].time);
+    for (size_t i = 0; i < expect.size() && i < 8; i++)
+      printf("  expected %u at %u\n", expect[i].id, expect[i].time);
+  }
+  calls.clear();
+}
+
+static void testAt(void) {
+  uint32_t now = chipTime();
+  int8_t a = scheduler.at(now + 100, task);
+  int8_t b = scheduler.at(now + 37, task);
+  runUntil(now + 200);
+  expectCalls("at()", {{(uint8_t) b, now + 37}, {(uint8_t) a, now + 100}});
+  if (scheduler.count())
+    FAIL("at(): %u alarms left", scheduler.count());
+}
+
+static void testEvery(void) {
+  uint32_t now = chipTime();
+  uint32_t first = now - now % 3600 + 300;
+  if (first <= now)
+    first += 3600;
+  int8_t id = scheduler.every(3600, task, 300);
+  runUntil(first + 23 * 3600);
+  std::vector<Call_t> expect;
+  for (uint8_t h = 0; h < 24; h++)
+    expect.push_back(Call_t{(uint8_t) id, first + h * 3600});
+  expectCalls("every(3600, task, 300)", expect);
+  if (!scheduler.cancel(id) || scheduler.cancel(id) || scheduler.count())
+    FAIL("every(): cancel() of a recurring alarm");
+}
+
+static void testCancel(void) {
+  uint32_t now = chipTime();
+  int8_t ids[7];
+  for (uint8_t i = 0; i < 7; i++)
+    ids[i] = scheduler.at(now + 60 + 10 * i, task);
+
+  // the root, the hardware alarm is moved to the next one
+  scheduler.cancel(ids[0]);
+  uint32_t before = wakes;
+  runUntil(now + 65);
+  if (wakes != before)
+    FAIL("cancel() of the root: woken at the time of the cancelled alarm");
+
+  // inside the heap
+  scheduler.cancel(ids[4]);
+  scheduler.cancel(ids[2]);
+  runUntil(now + 200);
+  expectCalls("cancel()", {{(uint8_t) ids[1], now + 70}, {(uint8_t) ids[3], now + 90},
+                           {(uint8_t) ids[5], now + 110}, {(uint8_t) ids[6], now + 120}});
+  if (scheduler.cancel(ids[0]) || scheduler.cancel(CAPACITY))
+    FAIL("cancel() of a free or an invalid id");
+}
+
+static void testPool(void) {
+  uint32_t now = chipTime();
+  int8_t ids[CAPACITY];
+  for (uint8_t i = 0; i < CAPACITY; i++) {
+    ids[i] = scheduler.at(now + 1000 + i, task);
+    if (ids[i] < 0)
+      FAIL("pool: alarm %u refused", i);
+  }
+  if (scheduler.at(now + 2000, task) != -1)
+    FAIL("pool: an alarm accepted with the pool full");
+  scheduler.cancel(ids[5]);
+  int8_t again = scheduler.at(now + 500, task);
+  if (again != ids[5])
+    FAIL("pool: id %d given after the cancel of %d", again, ids[5]);
+  for (uint8_t i = 0; i < CAPACITY; i++)
+    scheduler.cancel(ids[i]);
+  if (scheduler.count())
+    FAIL("pool: %u alarms left", scheduler.count());
+}
+
+// The ON_DATE alarm matches the day of the month, not the month: an alarm
+// 40 days away first matches in the current month and service() must go
+// back to sleep without calling the task
+static void testFar(void) {
+  uint32_t now = chipTime();
+  uint32_t due = now + 40 * 86400UL + 7;
+  int8_t id = scheduler.at(due, task);
+  uint32_t before = wakes;
+  runUntil(due + 60);
+  expectCalls("at() 40 days away", {{(uint8_t) id, due}});
+  if (wakes - before != 2)
+    FAIL("at() 40 days away: %u wakeups, expected 2 (one a month early)", wakes - before);
+}
+
+// Random at()/every()/cancel() against a reference of the due times
+static void testRandom(void) {
+  srand(3231);
+  uint32_t start = chipTime();
+  std::vector<Call_t> expect;
+  uint32_t due[CAPACITY], period[CAPACITY];
+  bool used[CAPACITY] = {false};
+  uint32_t now = start;
+
+  for (uint16_t step = 0; step < 2000; step++) {
+    uint32_t end = now + 1 + rand() % 900;
+    // the reference, in the order of the due times then of the ids
+    for (;;) {
+      int8_t next = -1;
+      for (uint8_t i = 0; i < CAPACITY; i++)
+        if (used[i] && due[i] <= end && (next < 0 || due[i] < due[next]))
+          next = i;
+      if (next < 0)
+        break;
+      expect.push_back(Call_t{(uint8_t) next, due[next]});
+      if (period[next])
+        due[next] += period[next];
+      else
+        used[next] = false;
+    }
+    runUntil(end);
+    now = end;
+
+    int op = rand() % 3;
+    if (op == 0 && scheduler.count() < CAPACITY) {
+      uint32_t when = now + 1 + rand() % 3000;
+      int8_t id = scheduler.at(when, task);
+      used[id] = true; due[id] = when; period[id] = 0;
+    }
+    else if (op == 1 && scheduler.count() < CAPACITY) {
+      uint32_t p = 60 * (1 + rand() % 30), offset = rand() % p;
+      int8_t id = scheduler.every(p, task, offset);
+      uint32_t when = now - now % p + offset;
+      if (when <= now)
+        when += p;
+      used[id] = true; due[id] = when; period[id] = p;
+    }
+    else {
+      uint8_t id = rand() % CAPACITY;
+      if (scheduler.cancel(id) != used[id])
+        FAIL("random: cancel(%u) of a %s alarm", id, used[id] ? "scheduled" : "free");
+      used[id] = false;
+    }
+  }
+
+  // alarms due at the same second may be called in any order
+  auto order = [](const Call_t &a, const Call_t &b) { return a.time != b.time ? a.time < b.time : a.id < b.id; };
+  std::sort(calls.begin(), calls.end(), order);
+  std::sort(expect.begin(), expect.end(), order);
+  printf("random: %u calls over %.1f days\n", (unsigned) expect.size(), (now - start) / 86400.0);
+  expectCalls("random", expect);
+}
+
+int main() {
+  hostSetClock(virtualMicros, virtualDelay);
+  bus.attach(DS3231_ADDRESS, &sim);
+  rtc.begin(&bus);
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 1; dt.tm_mday = 20; dt.tm_hour = 10; dt.tm_min = 42; dt.tm_sec = 11;
+  dt.tm_wday = DS3231::weekDay(24, 1, 20);
+  rtc.adjust(dt);
+  scheduler.begin(&rtc);
+
+  testAt();
+  testEvery();
+  testCancel();
+  testPool();
+  testFar();
+  testRandom();
+  hostSetClock(nullptr, nullptr);
+
+  printf("%u wakeups\n", wakes);
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
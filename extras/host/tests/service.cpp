@@ -0,0 +1,143 @@
+// DS3231::notify()/service() on DS3231Sim, notify() called by the INT pin
+// of the model. Checks that both alarm flags are serviced from one read of
+// STATUS and cleared by one write, with the callbacks called in order, that
+// a flag set between that read and the write is kept for the next
+// service(), the other STATUS bits, and latency() from notify().
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o service extras/host/tests/service.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./service
+#include <DS3231.h>
+#include <DS3231Sim.h>
+#include <vector>
+
+#define A1F  (1 << DS3231_STATUS_ALARM1_FLAG)
+#define A2F  (1 << DS3231_STATUS_ALARM2_FLAG)
+
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+// DS3231Sim that fires Alarm 2 right after the next read of STATUS
+class RacingSim : public DS3231Sim
+{
+public:
+  bool armed{false};
+
+  bool onWrite(const uint8_t *data, size_t len) override {
+    _pointer = data[0];
+    return DS3231Sim::onWrite(data, len);
+  }
+  bool onRead(uint8_t *data, size_t len) override {
+    bool ok = DS3231Sim::onRead(data, len);
+    if (armed && _pointer <= DS3231_STATUS && _pointer + len > DS3231_STATUS) {
+      setReg(DS3231_STATUS, reg(DS3231_STATUS) | A2F);
+      armed = false;
+    }
+    return ok;
+  }
+
+private:
+  uint8_t _pointer{0};
+};
+
+static RacingSim sim;
+static TwoWire bus;
+static DS3231 rtc;
+static std::vector<uint8_t> calls;
+
+static uint64_t virtualMicros(void) { return sim.micros(); }
+static void virtualDelay(uint64_t usec) { sim.advance(usec); }
+static void isr(void) { rtc.notify(); }
+static void alarm(uint8_t alarm_num) { calls.push_back(alarm_num); }
+
+// service() with the transactions and bytes it took
+static uint8_t service(uint32_t *tx, uint32_t *bytes) {
+  uint32_t t = bus.stats().transactions, b = bus.stats().bytes;
+  uint8_t fired = rtc.service();
+  *tx = bus.stats().transactions - t;
+  *bytes = bus.stats().bytes - b;
+  return fired;
+}
+
+static void testBoth(const char *name) {
+  // Alarm 1 every second, Alarm 2 every minute: both flags at the minute
+  DateTime dt{};
+  rtc.setAlarm1(&dt, DS3231_ALARM1_EVERY_SECOND);
+  rtc.setAlarm2(&dt, DS3231_ALARM2_EVERY_MINUTE);
+  dt.tm_year = 24; dt.tm_mon = 4; dt.tm_mday = 3; dt.tm_hour = 10; dt.tm_min = 20; dt.tm_sec = 59;
+  dt.tm_wday = DS3231::weekDay(24, 4, 3);
+  rtc.adjust(dt);
+  sim.setReg(DS3231_STATUS, sim.reg(DS3231_STATUS) & ~(A1F | A2F));
+  rtc.service();
+  calls.clear();
+  sim.advanceUntilInterrupt(2000000ULL);
+  uint8_t before = sim.reg(DS3231_STATUS);
+  if ((before & (A1F | A2F)) != (A1F | A2F) || !rtc.isPending())
+    FAIL("%s: STATUS %02x pending %u, expected both flags and a notify()", name, before, rtc.isPending());
+
+  uint32_t tx, bytes;
+  sim.advance(500);
+  uint8_t fired = service(&tx, &bytes);
+  uint8_t status = sim.reg(DS3231_STATUS);
+  if (fired != 3 || calls != std::vector<uint8_t>{1, 2})
+    FAIL("%s: service() returned %u with %u callbacks, expected 3 and Alarm 1 then 2", name, fired, (unsigned) calls.size());
+  if (tx != 2 || bytes != 1 + 1 + 2)
+    FAIL("%s: service() took %u transactions of %u bytes, expected one read and one write of STATUS", name, tx, bytes);
+  if ((status & (A1F | A2F)) || (status & ~(A1F | A2F)) != (before & ~(A1F | A2F)))
+    FAIL("%s: STATUS %02x after service(), %02x before", name, status, before);
+  if (rtc.isPending() || rtc.latency() < 500 || rtc.latency() > 500 + 1000 || rtc.maxLatency() < rtc.latency())
+    FAIL("%s: latency() %u maxLatency() %u, expected 500us plus the bus time", name, rtc.latency(), rtc.maxLatency());
+
+  // the next second only Alarm 1
+  calls.clear();
+  sim.advanceUntilInterrupt(2000000ULL);
+  fired = service(&tx, &bytes);
+  if (fired != 1 || calls != std::vector<uint8_t>{1} || tx != 2 || (sim.reg(DS3231_STATUS) & (A1F | A2F)))
+    FAIL("%s: Alarm 1 alone: service() %u with %u callbacks in %u transactions", name, fired, (unsigned) calls.size(), tx);
+
+  // nothing fired: one read, no write, no callback
+  calls.clear();
+  fired = service(&tx, &bytes);
+  if (fired != 0 || !calls.empty() || tx != 1)
+    FAIL("%s: nothing fired: service() %u in %u transactions", name, fired, tx);
+
+  // Alarm 2 fires between the read and the write of STATUS
+  sim.advanceUntilInterrupt(2000000ULL);
+  calls.clear();
+  sim.armed = true;
+  fired = service(&tx, &bytes);
+  if (fired != 1 || !(sim.reg(DS3231_STATUS) & A2F))
+    FAIL("%s: Alarm 2 fired during service(): returned %u, STATUS %02x", name, fired, sim.reg(DS3231_STATUS));
+  fired = service(&tx, &bytes);
+  if (fired != 2 || calls != std::vector<uint8_t>{1, 2} || (sim.reg(DS3231_STATUS) & A2F))
+    FAIL("%s: the next service() returned %u, expected Alarm 2", name, fired);
+
+  // no callback registered, the flag is still cleared
+  rtc.onAlarm(1, nullptr);
+  calls.clear();
+  sim.advanceUntilInterrupt(2000000ULL);
+  fired = service(&tx, &bytes);
+  if (fired != 1 || !calls.empty() || (sim.reg(DS3231_STATUS) & A1F))
+    FAIL("%s: without a callback: service() %u, STATUS %02x", name, fired, sim.reg(DS3231_STATUS));
+  rtc.onAlarm(1, alarm);
+}
+
+int main() {
+  hostSetClock(virtualMicros, virtualDelay);
+  bus.attach(DS3231_ADDRESS, &sim);
+  sim.onInterrupt(isr);
+  rtc.begin(&bus);
+  rtc.onAlarm(1, alarm);
+  rtc.onAlarm(2, alarm);
+
+  testBoth("plain");
+  rtc.enableShadow();
+  testBoth("shadow");
+  hostSetClock(nullptr, nullptr);
+
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
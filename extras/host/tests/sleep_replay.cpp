@@ -0,0 +1,129 @@
+// Year-long replay of DS3231Sleep schedules on DS3231Sim with an energy
+// proxy. The MCU sleeps with advanceUntilInterrupt(), which jumps from one
+// alarm match to the next, and is awake from the INT edge until the next
+// alarm is armed. Checks that every wakeup happens at its due time and none
+// is missed, and prints per day the wakeups, the I2C transactions and bytes
+// and the awake microseconds spent on the bus (at 100kHz, the MCU work of
+// the application is not counted).
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o sleep_replay extras/host/tests/sleep_replay.cpp
+//     src/DS3231.cpp src/DS3231Sleep.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./sleep_replay
+#include <DS3231Sleep.h>
+#include <DS3231Sim.h>
+
+#define DAYS 365
+
+static DS3231Sim *sim;
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+static uint64_t virtualMicros(void) { return sim->micros(); }
+static void virtualDelay(uint64_t usec) { sim->advance(usec); }
+
+// Time of the chip read from the model, not counted on the bus
+static uint32_t chipTime(const DS3231Sim &chip) {
+  DS3231Snapshot snap;
+  for (uint8_t i = 0; i < DS3231_REGISTERS; i++)
+    snap.reg[i] = chip.reg(i);
+  return DS3231::toEpoch(snap.now());
+}
+
+typedef struct {
+  const char *name;
+  uint32_t period;      // seconds between the samples
+  bool shadow;
+  uint8_t options;      // DS3231_SLEEP_*
+} Schedule_t;
+
+static void replay(const Schedule_t &schedule) {
+  DS3231Sim chip;
+  TwoWire bus;
+  DS3231 rtc;
+  DS3231Sleep sleeper;
+  sim = &chip;
+  bus.attach(DS3231_ADDRESS, &chip);
+  rtc.begin(&bus);
+  if (schedule.shadow)
+    rtc.enableShadow();
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 1; dt.tm_mday = 1;
+  dt.tm_wday = DS3231::weekDay(24, 1, 1);
+  rtc.adjust(dt);
+  rtc.setSquareWaveRate(DS3231_SQW_1HZ);
+  sleeper.begin(&rtc, schedule.options);
+
+  uint32_t start = chipTime(chip);
+  uint32_t end = start + DAYS * 86400UL;
+  uint32_t expected = (DAYS * 86400UL + schedule.period - 1) / schedule.period;
+  uint32_t wakes = 0, early = 0;
+  uint64_t awake = 0;
+  bus.resetStats();
+  sleeper.resetStats();
+
+  uint64_t edge = chip.micros();
+  while (true) {
+    if (!sleeper.sleepFor(schedule.period)) {
+      FAIL("%s: the wakeup at %u has already passed", schedule.name, sleeper.due());
+      break;
+    }
+    awake += chip.micros() - edge;
+    if (chip.out32kEnabled())
+      FAIL("%s: 32kHz output on while sleeping", schedule.name);
+
+    // sleeps until the alarm, back to sleep on an early one
+    bool due = false;
+    while (!due) {
+      chip.advanceUntilInterrupt(2 * schedule.period * 1000000ULL + 1000000ULL);
+      edge = chip.micros();
+      if (!chip.intLow()) {
+        FAIL("%s: no wakeup for %u after %u", schedule.name, sleeper.due(), wakes);
+        return;
+      }
+      due = sleeper.wake();
+      if (!due) {
+        early++;
+        awake += chip.micros() - edge;
+      }
+    }
+    wakes++;
+    uint32_t now = chipTime(chip);
+    if (now != sleeper.due())
+      FAIL("%s: woken at %u for %u", schedule.name, now, sleeper.due());
+    if (now >= end)
+      break;
+  }
+  if (wakes != expected)
+    FAIL("%s: %u wakeups, expected %u", schedule.name, wakes, expected);
+
+  const DS3231SleepStats_t &stats = sleeper.stats();
+  const TwoWireStats_t &wire = bus.stats();
+  double days = (sleeper.due() - start) / 86400.0;
+  printf("%-26s %8.2f %7.3f %8.1f %7.0f %10.0f %7.2f\n", schedule.name,
+    wakes / days, early / days, wire.transactions / days, wire.bytes / days, awake / days,
+    (double) stats.transactions / stats.wakeups);
+}
+
+int main() {
+  static const Schedule_t schedules[] = {
+    {"10 min",                   600, false, DS3231_SLEEP_BATTERY},
+    {"10 min, shadow",           600, true,  DS3231_SLEEP_BATTERY},
+    {"10 min, shadow, restore",  600, true,  DS3231_SLEEP_BATTERY | DS3231_SLEEP_RESTORE},
+    {"1 hour, shadow",          3600, true,  DS3231_SLEEP_BATTERY},
+    {"37 s (Alarm 1), shadow",    37, true,  DS3231_SLEEP_BATTERY},
+    {"1 day, shadow",          86400, true,  DS3231_SLEEP_BATTERY},
+    {"45 days, shadow",      3888000, true,  DS3231_SLEEP_BATTERY},
+  };
+  hostSetClock(virtualMicros, virtualDelay);
+
+  printf("%-26s %8s %7s %8s %7s %10s %7s\n", "schedule", "wakes/d", "early/d", "I2C tx/d", "bytes/d", "awake us/d", "tx/wake");
+  for (const Schedule_t &s : schedules)
+    replay(s);
+  hostSetClock(nullptr, nullptr);
+
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+// DS3231Thermometer on DS3231Sim with the virtual time. Checks that read()
+// only goes to the bus once the next 64s conversion is due, that a read
+// finding BSY set and a forced conversion wait for the new temperature, the
+// ring buffer of the history once it wraps, and the 32-bit integer rate()
+// against a double precision least squares fit of the same samples.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o thermometer extras/host/tests/thermometer.cpp
+//     src/DS3231.cpp src/DS3231Thermometer.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./thermometer
+#include <DS3231Thermometer.h>
+#include <DS3231Sim.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define BSY        (1 << DS3231_STATUS_BUSY)
+#define HISTORIES  2000   // random histories per spacing of rate()
+
+static DS3231Sim sim;
+static TwoWire bus;
+static DS3231 rtc;
+static DS3231Thermometer thermometer;
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+static uint64_t virtualMicros(void) { return sim.micros(); }
+static void virtualDelay(uint64_t usec) { sim.advance(usec); }
+
+static uint32_t transactions(void) { return bus.stats().transactions; }
+
+// Writes a temperature to the registers, as a conversion would
+static void setRegisters(int16_t raw) {
+  sim.setTemperature(raw * 0.25f);
+  sim.setReg(DS3231_TEMPERATURE, static_cast<uint8_t>(raw >> 2));
+  sim.setReg(DS3231_TEMPERATURE + 1, static_cast<uint8_t>((raw & 0x03) << 6));
+}
+
+static void testCache(void) {
+  thermometer.begin(&rtc);
+  setRegisters(93);
+  uint32_t before = transactions();
+  if (thermometer.read() != 93 || transactions() - before != 1 || thermometer.samples() != 1)
+    FAIL("cache: first read() %d after %u transactions", thermometer.last(), transactions() - before);
+
+  // nothing read until the next conversion is due, even when it changed
+  setRegisters(101);
+  before = transactions();
+  for (uint8_t s = 0; s < 63; s++) {
+    sim.advance(1000000);
+    if (thermometer.read() != 93)
+      FAIL("cache: read() %d after %us, expected the cached 93", thermometer.last(), s + 1);
+  }
+  if (transactions() != before || thermometer.samples() != 1)
+    FAIL("cache: %u transactions within 64s", transactions() - before);
+
+  sim.advance(1000000);
+  before = transactions();
+  if (thermometer.read() != 101 || transactions() - before != 1 || thermometer.samples() != 2)
+    FAIL("cache: read() %d after 64s with %u transactions, expected 101 with 1", thermometer.last(), transactions() - before);
+  if (thermometer.update())
+    FAIL("cache: update() took a new sample right after read()");
+}
+
+static void testBusy(void) {
+  thermometer.begin(&rtc);
+  setRegisters(80);
+  thermometer.update();
+
+  // an automatic conversion in progress: the sample waits for its result
+  sim.advance(64000000);
+  sim.setReg(DS3231_STATUS, sim.reg(DS3231_STATUS) | BSY);
+  if (thermometer.convert() || thermometer.isConverting())
+    FAIL("BSY: convert() started a conversion during the automatic one");
+  if (thermometer.update() || !thermometer.isConverting() || thermometer.samples() != 1)
+    FAIL("BSY: update() took a sample during the conversion");
+  uint32_t before = transactions();
+  if (thermometer.update() || transactions() - before != 1)
+    FAIL("BSY: update() during the conversion took %u transactions, expected 1", transactions() - before);
+  sim.setReg(DS3231_STATUS, sim.reg(DS3231_STATUS) & ~BSY);
+  setRegisters(84);
+  if (!thermometer.update() || thermometer.last() != 84 || thermometer.isConverting())
+    FAIL("BSY: update() after the conversion read %d, expected 84", thermometer.last());
+
+  // a forced conversion, CONV and BSY until the result is written
+  sim.setTemperature(30.0f);
+  if (!thermometer.convert() || !thermometer.isConverting())
+    FAIL("CONV: convert() failed");
+  if (!(sim.reg(DS3231_CONTROL) & (1 << DS3231_CONTROL_CONV)) || !(sim.reg(DS3231_STATUS) & BSY))
+    FAIL("CONV: CONV/BSY not set by convert()");
+  if (!thermometer.convert())
+    FAIL("CONV: a second convert() during the conversion failed");
+  sim.advance(50000);
+  if (thermometer.update() || thermometer.last() != 84)
+    FAIL("CONV: update() took a sample before the end of the conversion");
+  sim.advance(100000);
+  before = transactions();
+  if (!thermometer.update() || thermometer.last() != 120 || thermometer.samples() != 3)
+    FAIL("CONV: update() after the conversion read %d, expected 120", thermometer.last());
+  if (transactions() - before != 2)
+    FAIL("CONV: %u transactions for the sample, expected 2 (isConverting(), the temperature)", transactions() - before);
+}
+
+static void testHistory(void) {
+  thermometer.begin(&rtc);
+  if (thermometer.samples() != 0 || thermometer.trend() != 0 || thermometer.rate() != 0)
+    FAIL("history: not empty after begin()");
+  const uint8_t n = DS3231_THERMOMETER_HISTORY + 5;
+  for (uint8_t i = 0; i < n; i++) {
+    sim.advance(64000000);
+    setRegisters(-40 + 3 * i);
+    if (!thermometer.update())
+      FAIL("history: sample %u not taken", i);
+  }
+  if (thermometer.samples() != DS3231_THERMOMETER_HISTORY)
+    FAIL("history: %u samples, expected %u", thermometer.samples(), DS3231_THERMOMETER_HISTORY);
+  for (uint8_t age = 0; age < DS3231_THERMOMETER_HISTORY; age++)
+    if (thermometer.sample(age) != -40 + 3 * (n - 1 - age))
+      FAIL("history: sample(%u) %d, expected %d", age, thermometer.sample(age), -40 + 3 * (n - 1 - age));
+  if (thermometer.sample(DS3231_THERMOMETER_HISTORY) != 0)
+    FAIL("history: sample() past the oldest is %d", thermometer.sample(DS3231_THERMOMETER_HISTORY));
+  if (thermometer.trend() != 3 * (DS3231_THERMOMETER_HISTORY - 1))
+    FAIL("history: trend() %d, expected %d", thermometer.trend(), 3 * (DS3231_THERMOMETER_HISTORY - 1));
+  // 3 quarter degrees every 64s
+  int16_t expect = static_cast<int16_t>(lround(3 * 3600.0 / 64.0));
+  if (abs(thermometer.rate() - expect) > 1)
+    FAIL("history: rate() %d, expected %d", thermometer.rate(), expect);
+  if (thermometer.celsius() != thermometer.last() * 0.25f)
+    FAIL("history: celsius() %.2f of %d", thermometer.celsius(), thermometer.last());
+}
+
+// Least squares fit of the history in double precision, quarter degrees per hour
+static double referenceRate(const uint32_t *time, uint8_t count) {
+  double st = 0, sy = 0, stt = 0, sty = 0;
+  for (uint8_t age = 0; age < count; age++) {
+    double t = (time[age] - time[count - 1]) / 3600000.0;
+    double y = thermometer.sample(age);
+    st += t;
+    sy += y;
+    stt += t * t;
+    sty += t * y;
+  }
+  double d = count * stt - st * st;
+  if (d <= 0)
+    return 0;
+  double rate = (count * sty - st * sy) / d;
+  return fmax(-INT16_MAX, fmin(INT16_MAX, rate));
+}
+
+// Random histories with the samples spaced by min_ms to max_ms, taken by the
+// automatic conversions or, under 64s, by forced ones. Returns the largest
+// difference to the reference in LSB.
+static uint32_t testRate(const char *name, uint32_t min_ms, uint32_t max_ms, uint8_t step, uint32_t bound) {
+  uint32_t worst = 0;
+  for (uint32_t h = 0; h < HISTORIES; h++) {
+    thermometer.begin(&rtc);
+    uint8_t count = 2 + rand() % (DS3231_THERMOMETER_HISTORY - 1);
+    int16_t raw = rand() % 200 - 40;
+    uint32_t time[DS3231_THERMOMETER_HISTORY];
+    for (uint8_t i = 0; i < count; i++) {
+      uint32_t ms = min_ms + rand() % (max_ms - min_ms + 1);
+      raw += rand() % (2 * step + 1) - step;
+      if (ms < DS3231_THERMOMETER_PERIOD) {
+        sim.setTemperature(raw * 0.25f);
+        thermometer.convert();
+        sim.advance(ms * 1000ULL);
+      }
+      else {
+        sim.advance(ms * 1000ULL);
+        setRegisters(raw);
+      }
+      if (!thermometer.update()) {
+        FAIL("%s: sample %u of history %u not taken", name, i, h);
+        return worst;
+      }
+      // newest first, as sample()
+      memmove(&time[1], &time[0], (DS3231_THERMOMETER_HISTORY - 1) * sizeof(time[0]));
+      time[0] = millis();
+    }
+    if (thermometer.samples() != count)
+      FAIL("%s: %u samples, expected %u", name, thermometer.samples(), count);
+    double expect = referenceRate(time, count);
+    uint32_t error = static_cast<uint32_t>(lround(fabs(thermometer.rate() - expect)));
+    if (error > worst)
+      worst = error;
+    if (fabs(thermometer.rate() - expect) > bound)
+      FAIL("%s: rate() %d, reference %.2f for %u samples", name, thermometer.rate(), expect, count);
+  }
+  printf("rate() %s: at most %u LSB from the reference\n", name, worst);
+  return worst;
+}
+
+int main() {
+  hostSetClock(virtualMicros, virtualDelay);
+  bus.attach(DS3231_ADDRESS, &sim);
+  rtc.begin(&bus);
+
+  testCache();
+  testBusy();
+  testHistory();
+  srand(3231);
+  testRate("64s apart", 64000, 64100, 2, 1);
+  testRate("minutes to hours apart", 64000, 3 * 3600000UL, 8, 2);
+  testRate("under 1s apart", 130, 999, 1, 11);
+  hostSetClock(nullptr, nullptr);
+
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
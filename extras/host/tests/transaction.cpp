@@ -0,0 +1,137 @@
+// Read-modify-write of the STATUS flags on DS3231Sim. An alarm fires between
+// the read of STATUS and its write (inside a transaction, between the
+// staging and commit(), or on the bus between the two transfers of
+// DS3231T), and the write must not clear its flag. Also checks that
+// setAgingOffset() inside a transaction reports the staged value as
+// written and that commit() writes it.
+//
+//   g++ -O2 -std=gnu++11 -Iextras/host -Isrc -o transaction extras/host/tests/transaction.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./transaction
+#include <DS3231T.h>
+#include <DS3231Sim.h>
+
+#define A1F  (1 << DS3231_STATUS_ALARM1_FLAG)
+#define A2F  (1 << DS3231_STATUS_ALARM2_FLAG)
+#define EN32 (1 << DS3231_STATUS_EN32KHZ)
+
+static uint32_t failures = 0;
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+// DS3231Sim that fires Alarm 1 right after the next read of STATUS
+class RacingSim : public DS3231Sim
+{
+public:
+  bool armed{false};
+
+  bool onWrite(const uint8_t *data, size_t len) override {
+    _pointer = data[0];
+    return DS3231Sim::onWrite(data, len);
+  }
+  bool onRead(uint8_t *data, size_t len) override {
+    bool ok = DS3231Sim::onRead(data, len);
+    if (armed && _pointer <= DS3231_STATUS && _pointer + len > DS3231_STATUS) {
+      setReg(DS3231_STATUS, reg(DS3231_STATUS) | A1F);
+      armed = false;
+    }
+    return ok;
+  }
+
+private:
+  uint8_t _pointer{0};
+};
+
+// Alarm 1 every second, fired by the model one second later
+static void fireAlarm1(DS3231Sim &sim) {
+  sim.advance(1000000);
+  if (!(sim.reg(DS3231_STATUS) & A1F))
+    FAIL("the model did not fire Alarm 1");
+}
+
+static void transactions(bool shadow) {
+  const char *name = shadow ? "shadow" : "plain";
+  DS3231Sim sim;
+  TwoWire bus;
+  DS3231 rtc;
+  bus.attach(DS3231_ADDRESS, &sim);
+  rtc.begin(&bus);
+  if (shadow)
+    rtc.enableShadow();
+  DateTime dt{};
+  dt.tm_year = 24; dt.tm_mon = 6; dt.tm_mday = 1;
+  rtc.adjust(dt);
+  rtc.setAlarm1(&dt, DS3231_ALARM1_EVERY_SECOND);
+  rtc.clearAlarm(1);
+
+  // a flag outside the mask set after the staging
+  rtc.beginTransaction();
+  rtc.disable32K();
+  fireAlarm1(sim);
+  rtc.commit();
+  uint8_t status = sim.reg(DS3231_STATUS);
+  if (!(status & A1F) || (status & EN32))
+    FAIL("%s: disable32K() staged, Alarm 1 fired before commit(): STATUS %02x", name, status);
+
+  // the flag in the mask is cleared, the other one kept
+  sim.setReg(DS3231_STATUS, sim.reg(DS3231_STATUS) | A2F);
+  rtc.clearAlarm(1);
+  rtc.beginTransaction();
+  rtc.clearAlarm(2);
+  fireAlarm1(sim);
+  rtc.enable32K();
+  rtc.commit();
+  status = sim.reg(DS3231_STATUS);
+  if (!(status & A1F) || (status & A2F) || !(status & EN32))
+    FAIL("%s: clearAlarm(2) and enable32K() staged, Alarm 1 fired before commit(): STATUS %02x", name, status);
+
+  // the aging offset is verified only once written
+  rtc.beginTransaction();
+  if (!rtc.setAgingOffset(-12))
+    FAIL("%s: setAgingOffset() failed inside a transaction", name);
+  if (sim.reg(DS3231_AGING) != 0)
+    FAIL("%s: the aging offset written before commit()", name);
+  rtc.commit();
+  if (static_cast<int8_t>(sim.reg(DS3231_AGING)) != -12 || rtc.getAgingOffset() != -12)
+    FAIL("%s: aging offset %d after commit(), expected -12", name, static_cast<int8_t>(sim.reg(DS3231_AGING)));
+  if (!rtc.setAgingOffset(5) || sim.reg(DS3231_AGING) != 5)
+    FAIL("%s: setAgingOffset() outside a transaction", name);
+}
+
+// A flag set on the bus between the read and the write of STATUS
+template <typename Driver>
+static void readModifyWrite(const char *name, Driver &rtc, RacingSim &sim) {
+  sim.setReg(DS3231_STATUS, sim.reg(DS3231_STATUS) & ~(A1F | A2F));
+  sim.armed = true;
+  rtc.disable32K();
+  uint8_t status = sim.reg(DS3231_STATUS);
+  if (!(status & A1F) || (status & EN32))
+    FAIL("%s: Alarm 1 fired during disable32K(): STATUS %02x", name, status);
+
+  sim.setReg(DS3231_STATUS, sim.reg(DS3231_STATUS) | A2F);
+  sim.armed = true;
+  rtc.clearAlarm(2);
+  status = sim.reg(DS3231_STATUS);
+  if (!(status & A1F) || (status & A2F))
+    FAIL("%s: Alarm 1 fired during clearAlarm(2): STATUS %02x", name, status);
+}
+
+int main() {
+  transactions(false);
+  transactions(true);
+
+  RacingSim sim;
+  TwoWire bus;
+  bus.attach(DS3231_ADDRESS, &sim);
+  DS3231 rtc;
+  rtc.begin(&bus);
+  readModifyWrite("DS3231", rtc, sim);
+  DS3231T<TwoWire> rtcT(bus);
+  rtcT.begin();
+  readModifyWrite("DS3231T", rtcT, sim);
+
+  printf("%u failures\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+// Multi-year verification of the alarms and the calendar of the driver on
+// DS3231Sim. The years 2000 - 2199 are split across threads, each with its
+// own TwoWire and DS3231Sim. Every shard arms random alarms (both alarms,
+// every mode) and checks the second they fire, the alarm read back and
+// now()/epochNow() against a reference calendar. The simulator jumps from
+// one alarm match to the next, the throughput is printed in simulated years
+// per second of wall time.
+//
+//   g++ -O2 -std=gnu++11 -pthread -Iextras/host -Isrc -o verify extras/host/tests/verify.cpp
+//     src/DS3231.cpp extras/host/Arduino.cpp extras/host/Wire.cpp extras/host/DS3231Sim.cpp
+//   ./verify [threads] [seed]
+#include <DS3231.h>
+#include <DS3231Sim.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define FIRST_YEAR    2000
+#define LAST_YEAR     2199
+#define MAX_SPAN_DAYS 400    // an alarm on the 31st may wait for months
+
+static std::atomic<uint64_t> checks{0};
+static std::atomic<uint64_t> alarms{0};
+static std::atomic<uint64_t> failures{0};
+
+#define FAIL(...) do { \
+  if (failures++ < 20) { printf(__VA_ARGS__); printf("\n"); } \
+} while (0)
+
+// Reference calendar: days since 2000/01/01 of a Gregorian date and back
+static int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = static_cast<unsigned>(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int64_t>(doe) - 730425;
+}
+
+static void civilFromDays(int64_t z, int *y, int *m, int *d) {
+  z += 730425;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  unsigned doe = static_cast<unsigned>(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = static_cast<int>(yoe + era * 400 + (*m <= 2));
+}
+
+// A second of the reference calendar, with the date counted by the chip
+// (which takes 2100 as a leap year) for the alarm matching
+typedef struct {
+  int year, month, day, hour, minute, second, wday;
+  int chipDay;
+} Time_t;
+
+static const int64_t chipLeapDay = daysFromCivil(2100, 3, 1);  // 2100/02/29 for the chip
+
+static Time_t reference(uint64_t seconds) {
+  Time_t t;
+  int64_t days = seconds / 86400;
+  uint32_t sod = seconds % 86400;
+  civilFromDays(days, &t.year, &t.month, &t.day);
+  t.hour = sod / 3600;
+  t.minute = sod / 60 % 60;
+  t.second = sod % 60;
+  t.wday = static_cast<int>((days + 6) % 7);
+  t.chipDay = t.day;
+  if (days == chipLeapDay) {
+    t.chipDay = 29;
+  }
+  else if (days > chipLeapDay) {
+    int y, m;
+    civilFromDays(days - 1, &y, &m, &t.chipDay);
+  }
+  return t;
+}
+
+static DateTime toDateTime(uint64_t seconds) {
+  Time_t t = reference(seconds);
+  DateTime dt{};
+  dt.tm_year = t.year - 2000;
+  dt.tm_mon = t.month;
+  dt.tm_mday = t.day;
+  dt.tm_hour = t.hour;
+  dt.tm_min = t.minute;
+  dt.tm_sec = t.second;
+  dt.tm_wday = t.wday;
+  return dt;
+}
+
+static uint64_t toSeconds(const DateTime &dt) {
+  return daysFromCivil(dt.tm_year + 2000, dt.tm_mon, dt.tm_mday) * 86400ULL + dt.tm_hour * 3600 + dt.tm_min * 60 + dt.tm_sec;
+}
+
+// An alarm in the register layout of the chip: the mask bits of the mode
+// from the lowest field (seconds for Alarm 1, minutes for Alarm 2) and DY/DT
+typedef struct {
+  uint8_t num;
+  uint8_t mode;
+  Time_t at;
+} Alarm_t;
+
+static bool masked(const Alarm_t &a, uint8_t field) {   // 0 seconds, 1 minutes, 2 hours, 3 day
+  if (a.num == 1)
+    return a.mode & (1 << field);
+  return field == 0 ? false : a.mode & (1 << (field - 1));
+}
+
+static bool onWeekday(const Alarm_t &a) {
+  return a.mode & (a.num == 1 ? 0x10 : 0x08);
+}
+
+static bool dayMatches(const Alarm_t &a, const Time_t &t) {
+  if (masked(a, 3))
+    return true;
+  return onWeekday(a) ? t.wday == a.at.wday : t.chipDay == a.at.chipDay;
+}
+
+// First second after from when the alarm matches
+static uint64_t nextMatch(const Alarm_t &a, uint64_t from) {
+  uint64_t s = from + 1;
+  for (;;) {
+    Time_t t = reference(s);
+    if (!dayMatches(a, t)) {
+      s = (s / 86400 + 1) * 86400;
+      continue;
+    }
+    if (!masked(a, 2) && t.hour != a.at.hour) {
+      s = (s / 3600 + 1) * 3600;
+      continue;
+    }
+    if (!masked(a, 1) && t.minute != a.at.minute) {
+      s = (s / 60 + 1) * 60;
+      continue;
+    }
+    uint8_t second = (a.num == 2) ? 0 : a.at.second;
+    if ((a.num == 2 || !masked(a, 0)) && t.second != second) {
+      s++;
+      continue;
+    }
+    return s;
+  }
+}
+
+static void shard(int firstYear, int lastYear, uint32_t seed) {
+  TwoWire bus;
+  DS3231Sim sim;
+  DS3231 rtc;
+  bus.attach(DS3231_ADDRESS, &sim);
+  rtc.begin(&bus);
+  if (seed & 1)
+    rtc.enableShadow();
+  std::mt19937 rng(seed);
+
+  uint64_t now = daysFromCivil(firstYear, 1, 1) * 86400ULL;
+  uint64_t end = daysFromCivil(lastYear + 1, 1, 1) * 86400ULL;
+  uint64_t wrap = daysFromCivil(LAST_YEAR + 1, 1, 1) * 86400ULL;  // the chip goes back to 2000
+  rtc.adjust(toDateTime(now));
+
+  static const uint8_t modes1[] = {DS3231_ALARM1_ON_SECOND, DS3231_ALARM1_ON_MINUTE, DS3231_ALARM1_ON_HOUR,
+                                   DS3231_ALARM1_ON_DATE, DS3231_ALARM1_ON_WEEKDAY};
+  static const uint8_t modes2[] = {DS3231_ALARM2_ON_MINUTE, DS3231_ALARM2_ON_HOUR,
+                                   DS3231_ALARM2_ON_DATE, DS3231_ALARM2_ON_WEEKDAY};
+
+  while (now < end) {
+    DateTime dt = rtc.now();
+    if (toSeconds(dt) != now || dt.tm_wday != reference(now).wday)
+      FAIL("now() %04d/%02d/%02d %02d:%02d:%02d wday %d at %llu", dt.tm_year + 2000, dt.tm_mon, dt.tm_mday,
+        dt.tm_hour, dt.tm_min, dt.tm_sec, dt.tm_wday, (unsigned long long) now);
+    if (now <= 0xFFFFFFFFULL && rtc.epochNow() != now)
+      FAIL("epochNow() %u at %llu", rtc.epochNow(), (unsigned long long) now);
+    checks++;
+
+    // a random alarm within 45 days
+    Alarm_t a;
+    a.num = 1 + rng() % 2;
+    a.mode = (a.num == 1) ? modes1[rng() % 5] : modes2[rng() % 4];
+    uint64_t target = now + 1 + rng() % (45 * 86400UL);
+    if (a.num == 2)
+      target = (target / 60 + 1) * 60;
+    a.at = reference(target);
+    uint64_t expect = nextMatch(a, now);
+    if (expect - now > MAX_SPAN_DAYS * 86400ULL || expect + 86400 >= wrap)
+      break;
+
+    DateTime at = toDateTime(target);
+    if (a.num == 1)
+      rtc.setAlarm1(&at, static_cast<DS3231_ALARM1_t>(a.mode));
+    else
+      rtc.setAlarm2(&at, static_cast<DS3231_ALARM2_t>(a.mode));
+    rtc.clearAlarm(a.num);
+
+    // read back: the mode, the time fields, the weekday or a date of the chip day
+    DateTime back{};
+    uint8_t mode;
+    if (a.num == 1)
+      mode = rtc.getAlarm1Status(&back);
+    else
+      mode = rtc.getAlarm2Status(&back);
+    if (mode != a.mode || back.tm_hour != a.at.hour || back.tm_min != a.at.minute ||
+        (a.num == 1 && back.tm_sec != a.at.second))
+      FAIL("alarm %u mode %02x read back mode %02x %02d:%02d:%02d", a.num, a.mode, mode, back.tm_hour, back.tm_min, back.tm_sec);
+    else if (onWeekday(a) && back.tm_wday != a.at.wday)
+      FAIL("alarm %u read back weekday %d, expected %d", a.num, back.tm_wday, a.at.wday);
+
+    // just before the match, then across it
+    sim.advance((expect - now) * 1000000ULL - 500000);
+    if (rtc.alarmFired(a.num))
+      FAIL("alarm %u mode %02x fired before %llu", a.num, a.mode, (unsigned long long) expect);
+    sim.advance(1000000);
+    if (!rtc.alarmFired(a.num))
+      FAIL("alarm %u mode %02x did not fire at %llu", a.num, a.mode, (unsigned long long) expect);
+    alarms++;
+    rtc.disableAlarm(a.num);
+    sim.advance(500000);   // on the next second boundary
+    now = expect + 1;
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned threads = (argc > 1) ? atoi(argv[1]) : std::thread::hardware_concurrency();
+  uint32_t seed = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 1234;
+  if (threads == 0)
+    threads = 1;
+
+  int years = LAST_YEAR - FIRST_YEAR + 1;
+  int span = (years + threads - 1) / threads;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned i = 0; i < threads && FIRST_YEAR + static_cast<int>(i) * span <= LAST_YEAR; i++) {
+    int first = FIRST_YEAR + i * span;
+    int last = (first + span - 1 < LAST_YEAR) ? first + span - 1 : LAST_YEAR;
+    pool.emplace_back(shard, first, last, seed + i);
+  }
+  for (auto &t : pool)
+    t.join();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%u shards, %llu alarms, %llu time checks, %llu failures\n", (unsigned) pool.size(),
+    (unsigned long long) alarms, (unsigned long long) checks, (unsigned long long) failures);
+  printf("%d years in %.2fs: %.0f simulated years/s\n", years, elapsed, years / elapsed);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Decode and summarise the binary dump of DS3231Instrumentation::dump().
+
+    python3 extras/instrumentation/decode_dump.py dump.bin
+    python3 extras/instrumentation/decode_dump.py --trace dump.bin
+
+The input may hold other bytes (e.g. the text printed by the sketch on the
+same serial port), every dump found by its "D3I" header is decoded. Prints
+for each method the calls, bytes, errors and the latency percentiles from
+the log2 histogram, and with --trace the transactions of the ring buffer.
+"""
+import argparse
+import struct
+import sys
+
+VERSION = 1
+
+# DS3231_METHOD_t, in order
+METHODS = [
+    'other', 'begin', 'lostPower', 'adjust', 'adjustAligned', 'now', 'epochNow',
+    'snapshot', 'readSquareWaveRate', 'setSquareWaveRate', 'getTemperature',
+    'getTemperatureRaw', 'startConversion', 'isConverting', 'getAgingOffset',
+    'setAgingOffset', 'setAlarm1', 'setAlarm2', 'getAlarm1Status', 'getAlarm2Status',
+    'isAlarmArmed', 'clearAlarm', 'disableAlarm', 'alarmFired', 'service',
+    'enable32K', 'disable32K', 'is32KEnabled', 'enableBBSQW', 'disableBBSQW',
+    'enableShadow', 'resync', 'commit',
+]
+
+# DS3231_ERROR_t
+ERRORS = ['ok', 'too long', 'nack address', 'nack data', 'other', 'timeout', 'short read', 'lock']
+
+TRACE_READ = 0x80
+
+
+def method_name(i):
+    return METHODS[i] if i < len(METHODS) else 'method %d' % i
+
+
+def bucket_limit(b, buckets):
+    """Upper bound in micros of the bucket b, None for the last one"""
+    return None if b == buckets - 1 else (1 << b) - 1
+
+
+def percentile(hist, p):
+    total = sum(hist)
+    if not total:
+        return None
+    seen = 0
+    for b, n in enumerate(hist):
+        seen += n
+        if seen * 100 >= total * p:
+            return b
+    return len(hist) - 1
+
+
+def fmt_bucket(b, buckets):
+    if b is None:
+        return '-'
+    limit = bucket_limit(b, buckets)
+    return '>=%d' % (1 << (b - 1)) if limit is None else '<=%d' % limit
+
+
+def decode(data, pos):
+    """Decode the dump at pos, returns (methods, trace, buckets, end) or None"""
+    if len(data) < pos + 8:
+        return None
+    magic, version, used, buckets, traced, _ = struct.unpack_from('<3sBBBBB', data, pos)
+    if magic != b'D3I' or version != VERSION:
+        return None
+    pos += 8
+    rec = struct.Struct('<BIIH%dH' % buckets)
+    ent = struct.Struct('<IHBBBB')
+    if len(data) < pos + used * rec.size + traced * ent.size:
+        return None
+    methods = []
+    for _ in range(used):
+        f = rec.unpack_from(data, pos)
+        methods.append({'id': f[0], 'calls': f[1], 'bytes': f[2], 'errors': f[3], 'latency': list(f[4:])})
+        pos += rec.size
+    trace = []
+    for _ in range(traced):
+        t = ent.unpack_from(data, pos)
+        trace.append({'time': t[0], 'latency': t[1], 'reg': t[2], 'len': t[3], 'result': t[4], 'method': t[5]})
+        pos += ent.size
+    return methods, trace, buckets, pos
+
+
+def summary(methods, trace, buckets, show_trace):
+    print('%-20s %10s %10s %8s %8s %8s %8s' % ('method', 'calls', 'bytes', 'errors', 'p50 us', 'p90 us', 'max us'))
+    for m in sorted(methods, key=lambda m: -m['bytes']):
+        hist = m['latency']
+        top = max((b for b, n in enumerate(hist) if n), default=None)
+        print('%-20s %10d %10d %8d %8s %8s %8s' % (
+            method_name(m['id']), m['calls'], m['bytes'], m['errors'],
+            fmt_bucket(percentile(hist, 50), buckets), fmt_bucket(percentile(hist, 90), buckets),
+            fmt_bucket(top, buckets)))
+    print('%-20s %10d %10d %8d' % ('total', sum(m['calls'] for m in methods),
+                                   sum(m['bytes'] for m in methods), sum(m['errors'] for m in methods)))
+
+    failed = [t for t in trace if t['result']]
+    print('trace: %d transactions, %d failed' % (len(trace), len(failed)))
+    if not show_trace:
+        return
+    first = trace[0]['time'] if trace else 0
+    for t in trace:
+        op = 'read ' if t['len'] & TRACE_READ else 'write'
+        result = ERRORS[t['result']] if t['result'] < len(ERRORS) else str(t['result'])
+        print('  %+10d us %6d us  %s 0x%02x x%-2d  %-8s %s' % (
+            (t['time'] - first) & 0xFFFFFFFF, t['latency'], op, t['reg'], t['len'] & ~TRACE_READ,
+            result, method_name(t['method'])))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('file', nargs='?', help='binary capture, stdin if omitted')
+    parser.add_argument('--trace', action='store_true', help='list the transactions of the trace')
+    args = parser.parse_args()
+
+    data = open(args.file, 'rb').read() if args.file else sys.stdin.buffer.read()
+    found = 0
+    pos = data.find(b'D3I')
+    while pos >= 0:
+        dump = decode(data, pos)
+        if dump:
+            methods, trace, buckets, end = dump
+            found += 1
+            print('dump %d at offset %d' % (found, pos))
+            summary(methods, trace, buckets, args.trace)
+            pos = end
+        else:
+            pos += 1
+        pos = data.find(b'D3I', pos)
+    if not found:
+        print('no dump found', file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Flash and SRAM used by the examples, built for env:ATtiny3217 of
+platformio.ini, against the budget in budget.json.
+
+    python3 extras/size/size_report.py              # all the examples
+    python3 extras/size/size_report.py DS3231       # one example
+    python3 extras/size/size_report.py --update     # write the sizes as the new budget
+
+Needs PlatformIO (pio) with the atmelmegaavr platform. Prints the totals of
+each example and the flash/SRAM of each symbol of the library, and exits
+with 1 when an example or a symbol of the library is over its budget.
+--update writes the measured sizes plus HEADROOM, with a limit for every
+symbol of the library of SYMBOL_MIN bytes or more (the tables and the large
+methods). A budget without the "symbols" written by --update has not been
+measured: its example is reported against it but never fails the check.
+"""
+import argparse
+import json
+import math
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+BUDGET = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'budget.json')
+ENV = 'ATtiny3217'
+
+FLASH_TYPES = 'tTrRwW'  # code and read-only data
+SRAM_TYPES = 'dDbBvV'   # initialised data also takes its initial value in flash
+HEADROOM = 0.02         # of the budget written by --update, over the measured size
+SYMBOL_MIN = 64         # bytes, smaller symbols of the library get no limit of their own
+
+
+def tool(name):
+    core = os.environ.get('PLATFORMIO_CORE_DIR', os.path.expanduser('~/.platformio'))
+    path = os.path.join(core, 'packages', 'toolchain-atmelavr', 'bin', name)
+    return path if os.path.exists(path) else name
+
+
+def build(example, build_dir):
+    subprocess.run(['pio', 'ci', os.path.join(ROOT, 'examples', example),
+                    '--lib', ROOT, '--project-conf', os.path.join(ROOT, 'platformio.ini'),
+                    '-e', ENV, '--build-dir', build_dir, '--keep-build-dir'],
+                   check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(build_dir, '.pio', 'build', ENV)
+
+
+def sections(elf):
+    out = subprocess.run([tool('avr-size'), '-A', elf], check=True, capture_output=True, text=True).stdout
+    size = {}
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith('.') and fields[1].isdigit():
+            size[fields[0]] = int(fields[1])
+    flash = size.get('.text', 0) + size.get('.rodata', 0) + size.get('.data', 0)
+    sram = size.get('.data', 0) + size.get('.bss', 0) + size.get('.noinit', 0)
+    return flash, sram
+
+
+def symbols(path):
+    out = subprocess.run([tool('avr-nm'), '-C', '-S', '--size-sort', path],
+                         check=True, capture_output=True, text=True).stdout
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4:
+            yield fields[3], int(fields[1], 16), fields[2]
+
+
+def library_symbols(build_dir, elf):
+    """Symbols of the library objects (lib*/DS3231/*.o) that are linked in the firmware"""
+    names = set()
+    for top, _, files in os.walk(build_dir):
+        if os.path.basename(top) == 'DS3231' and os.path.basename(os.path.dirname(top)).startswith('lib'):
+            for f in files:
+                if f.endswith('.o'):
+                    names.update(name for name, _, _ in symbols(os.path.join(top, f)))
+    return [(name, size, kind) for name, size, kind in symbols(elf) if name in names]
+
+
+def with_headroom(size):
+    return int(math.ceil(size * (1 + HEADROOM) / 4.0)) * 4
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('examples', nargs='*')
+    parser.add_argument('--update', action='store_true', help='write the sizes to budget.json')
+    args = parser.parse_args()
+
+    with open(BUDGET) as f:
+        budget = json.load(f)
+    examples = args.examples or sorted(os.listdir(os.path.join(ROOT, 'examples')))
+
+    over = False
+    unmeasured = []
+    work = tempfile.mkdtemp(prefix='ds3231-size-')
+    try:
+        for example in examples:
+            build_dir = build(example, os.path.join(work, example))
+            elf = os.path.join(build_dir, 'firmware.elf')
+            flash, sram = sections(elf)
+            limit = budget.get(example, {})
+            enforced = 'symbols' in limit
+            status = []
+            for key, used in (('flash', flash), ('sram', sram)):
+                if key in limit and used > limit[key]:
+                    status.append('%s over by %d' % (key, used - limit[key]))
+            if enforced:
+                over |= bool(status)
+            else:
+                unmeasured.append(example)
+                status.append('not enforced, budget not measured')
+            print('%-26s flash %6d / %-6s sram %5d / %-5s %s' % (
+                example, flash, limit.get('flash', '-'), sram, limit.get('sram', '-'),
+                ', '.join(status) or 'ok'))
+            symbol_limits = limit.get('symbols', {})
+            measured = {}
+            for name, size, kind in library_symbols(build_dir, elf):
+                where = 'sram ' if kind in SRAM_TYPES else 'flash' if kind in FLASH_TYPES else kind
+                status = ''
+                if name in symbol_limits:
+                    status = 'over by %d' % (size - symbol_limits[name]) if size > symbol_limits[name] else 'ok'
+                    over |= size > symbol_limits[name]
+                print('    %s %6d / %-6s %s  %s' % (where, size, symbol_limits.get(name, '-'), name, status))
+                if size >= SYMBOL_MIN:
+                    measured[name] = max(size, measured.get(name, 0))
+            if args.update:
+                budget[example] = {'flash': with_headroom(flash), 'sram': with_headroom(sram),
+                                   'symbols': {name: with_headroom(size) for name, size in sorted(measured.items())}}
+    finally:
+        shutil.rmtree(work, ignore_errors=True)
+
+    if args.update:
+        with open(BUDGET, 'w') as f:
+            json.dump(budget, f, indent=2, sort_keys=True)
+            f.write('\n')
+    elif unmeasured:
+        print('\nsize gate not enforced for %s: run with --update to measure the budget' % ', '.join(unmeasured))
+    return 1 if over and not args.update else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
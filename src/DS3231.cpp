@@ -1,5 +1,10 @@
 #include "DS3231.h"
 
+#ifdef DS3231_INSTRUMENTATION
+#define DS3231_PROBE(method)  DS3231Probe probe(&_instr, method)
+#else
+#define DS3231_PROBE(method)
+#endif
 
 /**************************************************************************/
 /*!
@@ -10,11 +15,15 @@
 */
 /**************************************************************************/
 bool DS3231::begin(TwoWire *wire, uint32_t speed) {
+  DS3231_PROBE(DS3231_METHOD_BEGIN);
   _wire = wire;
   _wire->begin();
   if (speed != 400000L) {
     _wire->setClock(speed);
   }
+#ifdef WIRE_HAS_TIMEOUT
+  _wire->setWireTimeout(DS3231_WIRE_TIMEOUT_US, true);
+#endif
   // 32kHz Enable bit is always 1 when power up, read indicated I2C is working
   return _read_register(DS3231_STATUS) & 0x08;
 }
@@ -27,6 +36,7 @@ bool DS3231::begin(TwoWire *wire, uint32_t speed) {
 */
 /**************************************************************************/
 bool DS3231::lostPower(void) {
+  DS3231_PROBE(DS3231_METHOD_LOST_POWER);
   return _read_register(DS3231_STATUS) >> DS3231_STATUS_OSC_STOP;
 }
 
@@ -37,20 +47,61 @@ bool DS3231::lostPower(void) {
 */
 /**************************************************************************/
 void DS3231::adjust(const DateTime &dt) {
-  uint8_t buffer[] = {
-    DS3231_TIME,
-    _bin2bcd(dt.tm_sec),
-    _bin2bcd(dt.tm_min),
-    _bin2bcd(dt.tm_hour),
-    _bin2bcd(dt.tm_mday),
-    _bin2bcd(dt.tm_wday + 1),
-    _bin2bcd(dt.tm_mon),
-    _bin2bcd(dt.tm_year)
-  };
+  DS3231_PROBE(DS3231_METHOD_ADJUST);
+  uint8_t buffer[8] = {DS3231_TIME};
+  _encode_time(dt, &buffer[1]);
+  _write_register(buffer, sizeof(buffer));
+
+  _update_status(1 << DS3231_STATUS_OSC_STOP, 0); // clear OSC STOP flag
+}
+
+/**************************************************************************/
+/*!
+  @brief  Set the date/time on a second boundary of an external time source
+  @param  epoch seconds since 2000/01/01 00:00:00 of the source
+  @param  usec microseconds into that second
+  @param  captured micros() when the source time was taken
+  @return Estimated residual offset in microseconds, the start of the
+  second of the DS3231 minus the start of the same second of the source,
+  positive when the DS3231 is behind. It is computed from micros() around
+  the write and the latency model below, the DS3231 is not read back: to
+  measure it, capture the next edge of the 1Hz square wave on the SQW pin.
+  @details Writing the seconds register restarts the countdown chain of
+  the DS3231, the new second starts on the acknowledge of the seconds byte.
+  The time registers are encoded for the next second boundary of the
+  source that leaves DS3231_ALIGN_MARGIN_US to spare, and the write starts
+  alignLatency() before it, waiting for up to a second. The latency of the
+  write is measured on every call and used by the next one, so call it
+  twice for the best accuracy. The acknowledge is taken as 28/83 of the
+  burst, clock stretching shifts it. The Oscillator Stop Flag is cleared
+  after the time write. Not to be called between beginTransaction() and
+  commit().
+*/
+/**************************************************************************/
+int32_t DS3231::adjustAligned(uint32_t epoch, uint32_t usec, uint32_t captured) {
+  DS3231_PROBE(DS3231_METHOD_ADJUST_ALIGNED);
+  // microseconds from the start of the second of the source to the earliest write
+  uint32_t ahead = usec + (micros() - captured) + _align_latency + DS3231_ALIGN_MARGIN_US;
+  uint32_t seconds = (ahead + 999999UL) / 1000000UL;
+  uint32_t boundary = captured - usec + seconds * 1000000UL;  // micros() of the second boundary
+
+  uint8_t buffer[8] = {DS3231_TIME};
+  DateTime dt;
+  fromEpoch(epoch + seconds, &dt);
+  _encode_time(dt, &buffer[1]);
+
+  uint32_t fire = boundary - _align_latency;
+  for (int32_t wait; (wait = (int32_t) (fire - micros())) > 0; )
+    delayMicroseconds((wait > 10000) ? 10000 : wait);
+
+  uint32_t start = micros();
   _write_register(buffer, sizeof(buffer));
+  // the seconds byte is acknowledged after 28 of the 83 bit times of the burst
+  // (START, address, register and seconds bytes out of 9 bytes and STOP)
+  _align_latency = (micros() - start) * 28UL / 83UL;
 
-  uint8_t statreg = _read_register(DS3231_STATUS);
-  _write_register(DS3231_STATUS, statreg & ~(1 << DS3231_STATUS_OSC_STOP)); // clear OSC STOP flag
+  _update_status(1 << DS3231_STATUS_OSC_STOP, 0); // clear OSC STOP flag
+  return (int32_t) (start + _align_latency - boundary);
 }
 
 /**************************************************************************/
@@ -60,23 +111,162 @@ void DS3231::adjust(const DateTime &dt) {
 */
 /**************************************************************************/
 DateTime DS3231::now() {
+  DS3231_PROBE(DS3231_METHOD_NOW);
   uint8_t buffer[7]{0};
   _read_register(DS3231_TIME, buffer, sizeof(buffer));
+  return _decode_time(buffer);
+}
 
-  DateTime dt {
-    .tm_sec	  = _bcd2bin(buffer[0]),
-    .tm_min	  = _bcd2bin(buffer[1]),
-    .tm_hour  = _bcd2bin(buffer[2] & 0x7F), // msb = 0/1 for 12/24 hours
-    .tm_mday  = _bcd2bin(buffer[4]),
-    .tm_wday  = _bcd2bin(buffer[3]-1),
-    .tm_mon	  = _bcd2bin(buffer[5] & 0x7F), // msb = Century
-    .tm_year  = _bcd2bin(buffer[6]),
-    .tm_yday  = 0,
-    .tm_isdst = 0
-  };
+/**************************************************************************/
+/*!
+  @brief  Read all the DS3231 registers (0x00 - 0x12) in a single burst
+  @return DS3231Snapshot object holding the raw registers, see DS3231Snapshot
+  for the decoded accessors
+  @details All the fields are sampled at the same instant and it replaces 
+  separate calls of now(), getTemperature(), getAlarm1Status(), 
+  getAlarm2Status(), lostPower() and alarmFired() with one transaction.
+  If the shadow registers are enabled, the shadow is refreshed as well.
+*/
+/**************************************************************************/
+DS3231Snapshot DS3231::snapshot() {
+  DS3231_PROBE(DS3231_METHOD_SNAPSHOT);
+  DS3231Snapshot snap;
+  memset(&snap, 0, sizeof(snap));
+  _read_register(DS3231_TIME, snap.reg, sizeof(snap.reg));
+  if (_shadowed)
+    _load_shadow(&snap.reg[DS3231_ALARM1]);
+  return snap;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Decode the time registers
+  @param  buffer the 7 time registers starting from DS3231_TIME
+  @return DateTime object
+*/
+/**************************************************************************/
+DateTime DS3231::_decode_time(const uint8_t *buffer) {
+  // assigned by field as the member order of struct tm differs between C libraries
+  DateTime dt{};
+  dt.tm_sec   = _bcd2bin(buffer[0]);
+  dt.tm_min   = _bcd2bin(buffer[1]);
+  dt.tm_hour  = _bcd2bin(buffer[2] & 0x7F); // msb = 0/1 for 12/24 hours
+  dt.tm_mday  = _bcd2bin(buffer[4]);
+  dt.tm_wday  = _bcd2bin(buffer[3]-1);
+  dt.tm_mon   = _bcd2bin(buffer[5] & 0x7F); // msb = Century
+  dt.tm_year  = _bcd2bin(buffer[6]) + ((buffer[5] & 0x80) ? 100 : 0);
+  _from_chip(&dt);
   return dt;
 }
 
+/**************************************************************************/
+/*!
+  @brief  Encode the time registers
+  @param  dt DateTime object
+  @param  buffer the 7 time registers starting from DS3231_TIME
+*/
+/**************************************************************************/
+void DS3231::_encode_time(const DateTime &dt, uint8_t *buffer) {
+  DateTime chip = dt;
+  _to_chip(&chip);
+  buffer[0] = _bin2bcd(chip.tm_sec);
+  buffer[1] = _bin2bcd(chip.tm_min);
+  buffer[2] = _bin2bcd(chip.tm_hour);
+  buffer[3] = _bin2bcd(chip.tm_wday + 1);
+  buffer[4] = _bin2bcd(chip.tm_mday);
+  buffer[5] = _bin2bcd(chip.tm_mon) | ((chip.tm_year >= 100) ? 0x80 : 0);  // msb = Century
+  buffer[6] = _bin2bcd(chip.tm_year % 100);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Check for a date after the 2100/02/29 counted by the DS3231
+  @param  yOff Offset of the year from 2000
+  @param  m Month (1 to 12)
+  @return True from 2100/03/01, the chip treats every year divisible by 4
+  as a leap year so its dates are one day behind from there
+*/
+/**************************************************************************/
+bool DS3231::_past_2100_leap(int16_t yOff, int8_t m) {
+  return yOff > 100 || (yOff == 100 && m > 2);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Convert a date of the chip calendar to the Gregorian calendar
+  @param  dt date as read from the chip, 2100/02/29 included
+*/
+/**************************************************************************/
+void DS3231::_from_chip(DateTime *dt) {
+  if (dt->tm_year == 100 && dt->tm_mon == 2 && dt->tm_mday == 29) {
+    dt->tm_mon = 3;
+    dt->tm_mday = 1;
+  }
+  else if (_past_2100_leap(dt->tm_year, dt->tm_mon)) {
+    // the next day
+    if (++dt->tm_mday > _month_start(dt->tm_year, dt->tm_mon) - _month_start(dt->tm_year, dt->tm_mon - 1)) {
+      dt->tm_mday = 1;
+      if (++dt->tm_mon > 12) {
+        dt->tm_mon = 1;
+        dt->tm_year++;
+      }
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  Convert a Gregorian date to the chip calendar
+  @param  dt date to be written to the chip
+*/
+/**************************************************************************/
+void DS3231::_to_chip(DateTime *dt) {
+  if (!_past_2100_leap(dt->tm_year, dt->tm_mon))
+    return;
+  // the previous day, 2100/03/01 is 2100/02/29 for the chip
+  if (--dt->tm_mday == 0) {
+    if (--dt->tm_mon == 0) {
+      dt->tm_mon = 12;
+      dt->tm_year--;
+    }
+    dt->tm_mday = (dt->tm_year == 100 && dt->tm_mon == 2) ? 29 :
+      _month_start(dt->tm_year, dt->tm_mon) - _month_start(dt->tm_year, dt->tm_mon - 1);
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  Day of the month of a date in the chip calendar, for an alarm
+*/
+/**************************************************************************/
+uint8_t DS3231::_chip_date(const DateTime *dt) {
+  DateTime chip = *dt;
+  _to_chip(&chip);
+  return chip.tm_mday;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Fill the date of a decoded alarm
+  @param  month the month and year registers of the current time
+  @param  isDayOfWeek true when the alarm matches the day of the week
+  @param  day day of the week (0 to 6) or date of the alarm
+  @param  dt DateTime of the alarm
+*/
+/**************************************************************************/
+void DS3231::_alarm_day(const uint8_t *month, bool isDayOfWeek, uint8_t day, DateTime *dt) {
+  dt->tm_mon = _bcd2bin(month[0] & 0x1F);
+  dt->tm_year = _bcd2bin(month[1]) + ((month[0] & 0x80) ? 100 : 0);
+  if (isDayOfWeek) {
+    dt->tm_mday = 0;
+    dt->tm_wday = day;  // 0 as Sunday, 6 as Saturday
+    return;
+  }
+  dt->tm_mday = day;
+  _from_chip(dt);
+  dt->tm_wday = weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday);
+}
+
 /**************************************************************************/
 /*!
   @brief  Read the SQW pin mode
@@ -84,7 +274,8 @@ DateTime DS3231::now() {
 */
 /**************************************************************************/
 DS3231_SQW_RATE_t DS3231::readSquareWaveRate() {
-  int rate = _read_register(DS3231_CONTROL) & ( 3 << DS3231_CONTROL_RS | (1 << DS3231_CONTROL_INTCON));
+  DS3231_PROBE(DS3231_METHOD_READ_SQW);
+  int rate = _read_control() & ( 3 << DS3231_CONTROL_RS | (1 << DS3231_CONTROL_INTCON));
   return static_cast<DS3231_SQW_RATE_t>(rate);
 }
 
@@ -96,9 +287,8 @@ DS3231_SQW_RATE_t DS3231::readSquareWaveRate() {
 */
 /**************************************************************************/
 void DS3231::setSquareWaveRate(DS3231_SQW_RATE_t rate) {
-  uint8_t ctrl = _read_register(DS3231_CONTROL);
-  ctrl &= ~DS3231_SQW_OFF; // reset bits
-  _write_register(DS3231_CONTROL, ctrl | rate);
+  DS3231_PROBE(DS3231_METHOD_SET_SQW);
+  _update_control(DS3231_SQW_OFF, rate);
 }
 
 /**************************************************************************/
@@ -108,9 +298,104 @@ void DS3231::setSquareWaveRate(DS3231_SQW_RATE_t rate) {
 */
 /**************************************************************************/
 float DS3231::getTemperature() {
-  uint8_t buffer[2]{0};
-  _read_register(DS3231_TEMPERATURE, buffer, sizeof(buffer));
-  return static_cast<float>(buffer[0]) + (buffer[1] >> 6) * 0.25f;
+  DS3231_PROBE(DS3231_METHOD_GET_TEMPERATURE);
+  return getTemperatureRaw() * 0.25f;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the current temperature without floating point
+  @param  busy set to true when a conversion is in progress, the
+  temperature registers will be updated when it completes, can be nullptr
+  @return temperature in signed Q8.2 fixed point (quarter degrees), e.g.
+  -7 for -1.75 degree Celsius
+  @details The DS3231 updates the temperature every 64 seconds, or when a
+  conversion is forced with startConversion().
+*/
+/**************************************************************************/
+int16_t DS3231::getTemperatureRaw(bool *busy) {
+  DS3231_PROBE(DS3231_METHOD_GET_TEMPERATURE_RAW);
+  uint8_t buffer[4]{0};  // STATUS, AGING and the 2 temperature registers
+  _read_register(DS3231_STATUS, buffer, sizeof(buffer));
+  if (busy)
+    *busy = (buffer[0] >> DS3231_STATUS_BUSY) & 0x01;
+  return _decode_temperature(&buffer[DS3231_TEMPERATURE - DS3231_STATUS]);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Force a temperature conversion
+  @return False if the DS3231 is busy with a conversion, try again later
+  @details The conversion takes up to 200ms, poll isConverting() instead
+  of waiting for it. The CONV bit clears itself, it is never kept in the
+  shadow registers.
+*/
+/**************************************************************************/
+bool DS3231::startConversion(void) {
+  DS3231_PROBE(DS3231_METHOD_START_CONVERSION);
+  if ((_read_register(DS3231_STATUS) >> DS3231_STATUS_BUSY) & 0x01)
+    return false;
+  _write_register(DS3231_CONTROL, _read_control() | (1 << DS3231_CONTROL_CONV));
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Check if a temperature conversion is in progress
+  @return True while a forced (CONV) or an automatic (BSY) conversion is
+  in progress
+*/
+/**************************************************************************/
+bool DS3231::isConverting(void) {
+  DS3231_PROBE(DS3231_METHOD_IS_CONVERTING);
+  uint8_t buffer[2]{0};  // CONTROL and STATUS
+  _read_register(DS3231_CONTROL, buffer, sizeof(buffer));
+  return ((buffer[0] >> DS3231_CONTROL_CONV) & 0x01) || ((buffer[1] >> DS3231_STATUS_BUSY) & 0x01);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the aging offset
+  @return aging offset, one LSB is about 0.1ppm of the oscillator frequency
+*/
+/**************************************************************************/
+int8_t DS3231::getAgingOffset(void) {
+  DS3231_PROBE(DS3231_METHOD_GET_AGING_OFFSET);
+  return static_cast<int8_t>(_read_register(DS3231_AGING));
+}
+
+/**************************************************************************/
+/*!
+  @brief  Set the aging offset and verify it
+  @param  offset a positive value slows the oscillator down, a negative
+  value speeds it up, about 0.1ppm per LSB at 25 degree Celsius
+  @return True if the value read back matches, always true inside a
+  transaction where the value is only staged until commit()
+  @details The new offset takes effect at the next temperature conversion,
+  a conversion is forced so that it applies right away. See
+  DS3231Calibration to estimate the offset.
+*/
+/**************************************************************************/
+bool DS3231::setAgingOffset(int8_t offset) {
+  DS3231_PROBE(DS3231_METHOD_SET_AGING_OFFSET);
+  _write_register(DS3231_AGING, static_cast<uint8_t>(offset));
+  if (!_transaction && getAgingOffset() != offset)
+    return false;
+  startConversion();  // when busy, the next automatic conversion applies it
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Decode the temperature registers
+  @param  buffer the 2 temperature registers starting from DS3231_TEMPERATURE
+  @return temperature in signed Q8.2 fixed point (quarter degrees)
+  @details The MSB is the signed integer part, the 2 most significant bits
+  of the LSB are the fraction.
+*/
+/**************************************************************************/
+int16_t DS3231::_decode_temperature(const uint8_t *buffer) {
+  return static_cast<int16_t>(static_cast<int8_t>(buffer[0]) * 4 + (buffer[1] >> 6));
 }
 
 /**************************************************************************/
@@ -125,26 +410,35 @@ float DS3231::getTemperature() {
 */
 /**************************************************************************/
 void DS3231::setAlarm1(const DateTime *dt, DS3231_ALARM1_t alarm_mode) {
+  DS3231_PROBE(DS3231_METHOD_SET_ALARM1);
 
   uint8_t A1M1 = (alarm_mode & 0x01) << 7;  // Seconds bit 7.
   uint8_t A1M2 = (alarm_mode & 0x02) << 6;  // Minutes bit 7.
   uint8_t A1M3 = (alarm_mode & 0x04) << 5;  // Hour bit 7.
   uint8_t A1M4 = (alarm_mode & 0x08) << 4;  // Day/Date bit 7.
   uint8_t DY_DT = (alarm_mode & 0x10) << 2; // Day/Date bit 6. Date when 0, day of week when 1.
-  uint8_t day = (DY_DT) ? weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday) + 1 : dt->tm_mday;
+  uint8_t day = (DY_DT) ? weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday) + 1 : _chip_date(dt);
 
+  // the mask bits are set after the BCD encoding
   uint8_t buffer[] = {
     DS3231_ALARM1, 
-    _bin2bcd(dt->tm_sec | A1M1),
-    _bin2bcd(dt->tm_min | A1M2),
-    _bin2bcd(dt->tm_hour | A1M3),
-    _bin2bcd(day | A1M4 | DY_DT)
+    (uint8_t) (_bin2bcd(dt->tm_sec) | A1M1),
+    (uint8_t) (_bin2bcd(dt->tm_min) | A1M2),
+    (uint8_t) (_bin2bcd(dt->tm_hour) | A1M3),
+    (uint8_t) (_bin2bcd(day) | A1M4 | DY_DT)
   };
-  _write_register(buffer, sizeof(buffer));
+  uint8_t arm = (1 << DS3231_CONTROL_INTCON | 1 << DS3231_CONTROL_ALARM1_INT_EN);
 
-  uint8_t ctrl = _read_register(DS3231_CONTROL);
-  ctrl |= (1 << DS3231_CONTROL_INTCON | 1 << DS3231_CONTROL_ALARM1_INT_EN);
-  _write_register(DS3231_CONTROL, ctrl);
+  if (_shadowed) {
+    // alarm registers and CONTROL are contiguous, one burst covers them all
+    memcpy(&_shadow_reg(DS3231_ALARM1), &buffer[1], sizeof(buffer) - 1);
+    _shadow_reg(DS3231_CONTROL) |= arm;
+    _write_shadow(DS3231_ALARM1, DS3231_CONTROL);
+    return;
+  }
+
+  _write_register(buffer, sizeof(buffer));
+  _update_control(arm, arm);
 
 }
 
@@ -160,40 +454,66 @@ void DS3231::setAlarm1(const DateTime *dt, DS3231_ALARM1_t alarm_mode) {
 */
 /**************************************************************************/
 void DS3231::setAlarm2(const DateTime *dt, DS3231_ALARM2_t alarm_mode) {
+  DS3231_PROBE(DS3231_METHOD_SET_ALARM2);
 
   uint8_t A2M2 = (alarm_mode & 0x01) << 7;  // Minutes bit 7.
   uint8_t A2M3 = (alarm_mode & 0x02) << 6;  // Hour bit 7.
   uint8_t A2M4 = (alarm_mode & 0x04) << 5;  // Day/Date bit 7.
   uint8_t DY_DT = (alarm_mode & 0x08) << 3; // Day/Date bit 6. Date when 0, day of week when 1.
-  uint8_t day = (DY_DT) ? weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday) + 1 : dt->tm_mday;
+  uint8_t day = (DY_DT) ? weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday) + 1 : _chip_date(dt);
 
   uint8_t buffer[] = {
     DS3231_ALARM2,
-    _bin2bcd(dt->tm_min | A2M2),
-    _bin2bcd(dt->tm_hour | A2M3),
-    _bin2bcd(day | A2M4 | DY_DT),
+    (uint8_t) (_bin2bcd(dt->tm_min) | A2M2),
+    (uint8_t) (_bin2bcd(dt->tm_hour) | A2M3),
+    (uint8_t) (_bin2bcd(day) | A2M4 | DY_DT),
   };
-  _write_register(buffer, sizeof(buffer));
+  uint8_t arm = (1 << DS3231_CONTROL_INTCON | 1 << DS3231_CONTROL_ALARM2_INT_EN);
 
-  uint8_t ctrl = _read_register(DS3231_CONTROL);
-  ctrl |= (1 << DS3231_CONTROL_INTCON | 1 << DS3231_CONTROL_ALARM2_INT_EN);
-  _write_register(DS3231_CONTROL, ctrl);
+  if (_shadowed) {
+    memcpy(&_shadow_reg(DS3231_ALARM2), &buffer[1], sizeof(buffer) - 1);
+    _shadow_reg(DS3231_CONTROL) |= arm;
+    _write_shadow(DS3231_ALARM2, DS3231_CONTROL);
+    return;
+  }
+
+  _write_register(buffer, sizeof(buffer));
+  _update_control(arm, arm);
 }
 
 /**************************************************************************/
 /*!
   @brief  Get Alarm 1 status
   @param  dt Pointer to an empty DateTime object
-  @param  mode Pointer to an empty ALARM1_MODE_t object
   @return enum value of DS3231_ALARM1_1, and dt object will populate the day,
-  hour, minutes, and seconds fields of the alarm.
+  hour, minutes, and seconds fields of the alarm, the year and month are
+  those of the current date.
 */
 /**************************************************************************/
 DS3231_ALARM1_t DS3231::getAlarm1Status(DateTime *dt) {
+  DS3231_PROBE(DS3231_METHOD_GET_ALARM1_STATUS);
+  // month and year registers followed by the alarm
+  uint8_t buffer[2 + 4] = {0};
+  if (_shadowed) {
+    _read_register(DS3231_TIME + 5, buffer, 2);
+    memcpy(&buffer[2], &_shadow_reg(DS3231_ALARM1), 4);
+  }
+  else {
+    _read_register(DS3231_TIME + 5, buffer, sizeof(buffer));
+  }
+  return _decode_alarm1(&buffer[2], buffer, dt);
+}
 
-  uint8_t buffer[4] = {0};
-  _read_register(DS3231_ALARM1, buffer, sizeof(buffer));
-
+/**************************************************************************/
+/*!
+  @brief  Decode the Alarm 1 registers
+  @param  buffer the 4 alarm registers starting from DS3231_ALARM1
+  @param  month the month and year registers of the current time
+  @param  dt Pointer to an empty DateTime object
+  @return alarm mode
+*/
+/**************************************************************************/
+DS3231_ALARM1_t DS3231::_decode_alarm1(const uint8_t *buffer, const uint8_t *month, DateTime *dt) {
   uint8_t seconds = _bcd2bin(buffer[0] & 0x7F);
   uint8_t minutes = _bcd2bin(buffer[1] & 0x7F);
   uint8_t hours = _bcd2bin(buffer[2] & 0x3F);
@@ -202,19 +522,15 @@ DS3231_ALARM1_t DS3231::getAlarm1Status(DateTime *dt) {
   bool isDayOfWeek = (buffer[3] & 0x40) >> 6;
   uint8_t day;
   if (isDayOfWeek) {
-    day = _bcd2bin((buffer[3] & 0x0F) - 1);  // day is the weekday, 0 as Sunday
+    day = (buffer[3] & 0x0F) - 1;  // day is the weekday, 0 as Sunday
   } else {
     day = _bcd2bin(buffer[3] & 0x3F);  // day is date (day of the month)
   }
 
-  // On 1 Jan 2024, the day-of-the-week number matches the date number.
   dt->tm_sec	= seconds;
   dt->tm_min	= minutes;
   dt->tm_hour = hours;
-  dt->tm_mday = (isDayOfWeek) ? 0 : day;
-  dt->tm_wday = (isDayOfWeek) ? day : 0; // 0 as Sunday, 6 as Saturday
-  dt->tm_mon	= 1;
-  dt->tm_year = 24;
+  _alarm_day(month, isDayOfWeek, day, dt);
 
   DS3231_ALARM1_t alarm_mode = (DS3231_ALARM1_t) 
   (   (buffer[0] & 0x80) >> 7  // A1M1 - Seconds bit
@@ -231,16 +547,35 @@ DS3231_ALARM1_t DS3231::getAlarm1Status(DateTime *dt) {
 /*!
   @brief  Get the date/time value of Alarm2
   @param  dt Pointer to an empty DateTime object
-  @param  mode Pointer to an empty ALARM1_MODE_t object
-  @return enum value of DS3231_ALARM1_1, and dt object will populate the day,
-  hour, minutes, and seconds fields of the alarm.
+  @return enum value of DS3231_ALARM2_t, and dt object will populate the day,
+  hour and minutes fields of the alarm, the year and month are those of
+  the current date.
 */
 /**************************************************************************/
-// DateTime DS3231::getAlarm2() {
 DS3231_ALARM2_t DS3231::getAlarm2Status(DateTime *dt) {
-  uint8_t buffer[3] = {0};
-  _read_register(DS3231_ALARM2, buffer, sizeof(buffer));
+  DS3231_PROBE(DS3231_METHOD_GET_ALARM2_STATUS);
+  // month and year registers, Alarm 1 and Alarm 2
+  uint8_t buffer[2 + 4 + 3] = {0};
+  if (_shadowed) {
+    _read_register(DS3231_TIME + 5, buffer, 2);
+    memcpy(&buffer[6], &_shadow_reg(DS3231_ALARM2), 3);
+  }
+  else {
+    _read_register(DS3231_TIME + 5, buffer, sizeof(buffer));
+  }
+  return _decode_alarm2(&buffer[6], buffer, dt);
+}
 
+/**************************************************************************/
+/*!
+  @brief  Decode the Alarm 2 registers
+  @param  buffer the 3 alarm registers starting from DS3231_ALARM2
+  @param  month the month and year registers of the current time
+  @param  dt Pointer to an empty DateTime object
+  @return alarm mode
+*/
+/**************************************************************************/
+DS3231_ALARM2_t DS3231::_decode_alarm2(const uint8_t *buffer, const uint8_t *month, DateTime *dt) {
   uint8_t minutes = _bcd2bin(buffer[0] & 0x7F);
   uint8_t hours = _bcd2bin(buffer[1] & 0x3F);
 
@@ -248,19 +583,15 @@ DS3231_ALARM2_t DS3231::getAlarm2Status(DateTime *dt) {
   bool isDayOfWeek = (buffer[2] & 0x40) >> 6;
   uint8_t day;
   if (isDayOfWeek) {
-    day = _bcd2bin((buffer[2] & 0x0F) - 1);  // day is the weekday, 0 as Sunday
+    day = (buffer[2] & 0x0F) - 1;  // day is the weekday, 0 as Sunday
   } else {
     day = _bcd2bin(buffer[2] & 0x3F);  // day is date (day of the month)
   }
 
-  // On 1 Jan 2024, the day-of-the-week number matches the date number.
   dt->tm_sec	= 0;
   dt->tm_min	= minutes;
   dt->tm_hour = hours;
-  dt->tm_mday = (isDayOfWeek) ? 0 : day;
-  dt->tm_wday = (isDayOfWeek) ? day : 0; // 0 as Sunday, 6 as Saturday
-  dt->tm_mon	= 1;
-  dt->tm_year = 24;
+  _alarm_day(month, isDayOfWeek, day, dt);
 
   DS3231_ALARM2_t alarm_mode = (DS3231_ALARM2_t) 
   (   (buffer[0] & 0x80) >> 7  // A2M2 - Minutes bit
@@ -280,7 +611,8 @@ DS3231_ALARM2_t DS3231::getAlarm2Status(DateTime *dt) {
 */
 /**************************************************************************/
 bool DS3231::isAlarmArmed(uint8_t alarm_num) {
-  uint8_t ctrl = _read_register(DS3231_CONTROL);
+  DS3231_PROBE(DS3231_METHOD_IS_ALARM_ARMED);
+  uint8_t ctrl = _read_control();
   if (alarm_num == 1)
     return (ctrl & ((1 << DS3231_CONTROL_ALARM1_INT_EN)));
   else
@@ -294,8 +626,8 @@ bool DS3231::isAlarmArmed(uint8_t alarm_num) {
 */
 /**************************************************************************/
 void DS3231::clearAlarm(uint8_t alarm_num) {
-  uint8_t status = _read_register(DS3231_STATUS);
-  _write_register(DS3231_STATUS, status & ~(1 << (alarm_num - 1)));
+  DS3231_PROBE(DS3231_METHOD_CLEAR_ALARM);
+  _update_status(1 << (alarm_num - 1), 0);
 }
 
 /**************************************************************************/
@@ -305,6 +637,19 @@ void DS3231::clearAlarm(uint8_t alarm_num) {
 */
 /**************************************************************************/
 void DS3231::disableAlarm(uint8_t alarm_num) {
+  DS3231_PROBE(DS3231_METHOD_DISABLE_ALARM);
+  if (_shadowed) {
+    // CONTROL and STATUS are adjacent, disarm and clear the flag in one write
+    _shadow_reg(DS3231_CONTROL) &= ~(1 << (alarm_num - 1));
+    uint8_t buffer[] = {
+      DS3231_CONTROL,
+      _shadow_reg(DS3231_CONTROL),
+      (uint8_t) (_shadow_status() & ~(1 << (alarm_num - 1)))
+    };
+    _write_register(buffer, sizeof(buffer));
+    return;
+  }
+
   uint8_t ctrl = _read_register(DS3231_CONTROL);
   _write_register(DS3231_CONTROL, ctrl & ~(1 << (alarm_num - 1)));
   clearAlarm(alarm_num);
@@ -318,9 +663,72 @@ void DS3231::disableAlarm(uint8_t alarm_num) {
 */
 /**************************************************************************/
 bool DS3231::alarmFired(uint8_t alarm_num) {
+  DS3231_PROBE(DS3231_METHOD_ALARM_FIRED);
   return (_read_register(DS3231_STATUS) >> (alarm_num - 1)) & 0x1;
 }
 
+/**************************************************************************/
+/*!
+  @brief  Register a callback for an alarm, called by service()
+  @param  alarm_num Alarm number
+  @param  callback function to be called when the alarm has fired, nullptr
+  to remove it
+*/
+/**************************************************************************/
+void DS3231::onAlarm(uint8_t alarm_num, DS3231AlarmCallback_t callback) {
+  _callbacks[alarm_num - 1] = callback;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Mark an alarm interrupt as pending
+  @details Call it from the ISR of the INT pin, it does not access the I2C
+  bus. The bus work is done by service() outside of the interrupt context.
+*/
+/**************************************************************************/
+void DS3231::notify(void) {
+  _notified = micros();
+  _pending = true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Service both alarms
+  @return bit mask of the alarms that have fired, bit 0 for Alarm 1 and
+  bit 1 for Alarm 2
+  @details Read STATUS once, clear all the fired flags with a single write
+  and call the registered callbacks. The latency from notify() to the 
+  first callback is available with latency() and maxLatency().
+*/
+/**************************************************************************/
+uint8_t DS3231::service(void) {
+  DS3231_PROBE(DS3231_METHOD_SERVICE);
+  noInterrupts();
+  bool notified = _pending;
+  uint32_t since = _notified;
+  _pending = false;
+  interrupts();
+
+  uint8_t status = _read_register(DS3231_STATUS);
+  uint8_t fired = status & ((1 << DS3231_STATUS_ALARM1_FLAG) | (1 << DS3231_STATUS_ALARM2_FLAG));
+  if (!fired)
+    return 0;
+
+  // writing 1 leaves the other flags unchanged, even if they are set in the meantime
+  _write_register(DS3231_STATUS, (status & (1 << DS3231_STATUS_EN32KHZ)) | (DS3231_STATUS_FLAGS & ~fired));
+
+  if (notified) {
+    _latency = micros() - since;
+    if (_latency > _latency_max)
+      _latency_max = _latency;
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    if ((fired & (1 << i)) && _callbacks[i])
+      _callbacks[i](i + 1);
+  }
+  return fired;
+}
+
 /**************************************************************************/
 /*!
   @brief  Enable 32KHz Output
@@ -329,8 +737,8 @@ bool DS3231::alarmFired(uint8_t alarm_num) {
 */
 /**************************************************************************/
 void DS3231::enable32K(void) {
-  uint8_t status = _read_register(DS3231_STATUS);
-  _write_register(DS3231_STATUS, status | (1 << DS3231_STATUS_EN32KHZ));
+  DS3231_PROBE(DS3231_METHOD_ENABLE_32K);
+  _update_status(1 << DS3231_STATUS_EN32KHZ, 1 << DS3231_STATUS_EN32KHZ);
 }
 
 /**************************************************************************/
@@ -339,9 +747,8 @@ void DS3231::enable32K(void) {
 */
 /**************************************************************************/
 void DS3231::disable32K(void) {
-  uint8_t status = _read_register(DS3231_STATUS);
-  status &= ~(1 << DS3231_STATUS_EN32KHZ);
-  _write_register(DS3231_STATUS, status);
+  DS3231_PROBE(DS3231_METHOD_DISABLE_32K);
+  _update_status(1 << DS3231_STATUS_EN32KHZ, 0);
 }
 
 /**************************************************************************/
@@ -351,7 +758,197 @@ void DS3231::disable32K(void) {
 */
 /**************************************************************************/
 bool DS3231::is32KEnabled(void) {
-  return (_read_register(DS3231_STATUS) >> DS3231_STATUS_EN32KHZ) & 0x01;
+  DS3231_PROBE(DS3231_METHOD_IS_32K_ENABLED);
+  return (_read_status_config() >> DS3231_STATUS_EN32KHZ) & 0x01;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Keep the SQW/INT output active on battery power (BBSQW)
+  @details With INTCN set, the alarms still assert INT when VCC is off, e.g.
+  to switch on the power of a logger.
+*/
+/**************************************************************************/
+void DS3231::enableBBSQW(void) {
+  DS3231_PROBE(DS3231_METHOD_ENABLE_BBSQW);
+  _update_control(1 << DS3231_CONTROL_BBSQW, 1 << DS3231_CONTROL_BBSQW);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Disable the SQW/INT output on battery power (default)
+*/
+/**************************************************************************/
+void DS3231::disableBBSQW(void) {
+  DS3231_PROBE(DS3231_METHOD_DISABLE_BBSQW);
+  _update_control(1 << DS3231_CONTROL_BBSQW, 0);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Enable the shadow registers
+  @details Keep a write-through copy of the alarm, CONTROL and STATUS 
+  registers in RAM. Configuration setters become single write transactions
+  and getters such as isAlarmArmed(), readSquareWaveRate() and is32KEnabled()
+  no longer access the I2C bus. The volatile status flags (A1F, A2F, OSF and
+  BSY) are always read from the chip. Call after begin().
+*/
+/**************************************************************************/
+void DS3231::enableShadow(void) {
+  DS3231_PROBE(DS3231_METHOD_ENABLE_SHADOW);
+  resync();
+  _shadowed = true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Disable the shadow registers, every access goes to the chip again
+*/
+/**************************************************************************/
+void DS3231::disableShadow(void) {
+  _shadowed = false;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Reload the shadow registers from the chip
+  @details Only needed if the registers might have been changed by something
+  other than this object, e.g. another MCU sharing the bus.
+*/
+/**************************************************************************/
+void DS3231::resync(void) {
+  DS3231_PROBE(DS3231_METHOD_RESYNC);
+  uint8_t buffer[sizeof(_shadow)]{0};
+  _read_register(DS3231_ALARM1, buffer, sizeof(buffer));
+  _load_shadow(buffer);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Start a transaction
+  @details The register writes of the methods called until commit() are
+  staged in RAM instead of being sent, a method that reads a staged register
+  gets the staged value. Transactions can be nested, only the outermost
+  commit() writes to the chip.
+*/
+/**************************************************************************/
+void DS3231::beginTransaction(void) {
+  _transaction++;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Write the staged registers
+  @return number of I2C transactions used
+  @details Adjacent staged registers are merged into one burst write. With
+  the shadow registers enabled, small gaps between the alarm, CONTROL and
+  STATUS registers are filled from the shadow so that e.g. configuring both 
+  alarms, SQW and 32K costs a single transaction.
+*/
+/**************************************************************************/
+uint8_t DS3231::commit(void) {
+  DS3231_PROBE(DS3231_METHOD_COMMIT);
+  if (_transaction == 0 || --_transaction > 0)
+    return 0;
+
+  uint8_t bursts = 0;
+  uint8_t reg = 0;
+  while (reg < DS3231_TEMPERATURE) {
+    if (!(_dirty & (1UL << reg))) {
+      reg++;
+      continue;
+    }
+
+    // extend the burst over staged registers and short fillable gaps
+    uint8_t last = reg;
+    uint8_t next = reg + 1;
+    while (next < DS3231_TEMPERATURE) {
+      if (_dirty & (1UL << next)) {
+        last = next++;
+        continue;
+      }
+      uint8_t gap = next;
+      while (gap < DS3231_TEMPERATURE && gap - next < DS3231_COMMIT_GAP && !(_dirty & (1UL << gap)) && _fillable(gap))
+        gap++;
+      if (gap < DS3231_TEMPERATURE && (_dirty & (1UL << gap)) && gap - next <= DS3231_COMMIT_GAP) {
+        next = gap;
+        continue;
+      }
+      break;
+    }
+
+    uint8_t buffer[DS3231_TEMPERATURE + 1];
+    buffer[0] = reg;
+    for (uint8_t i = reg; i <= last; i++)
+      buffer[i - reg + 1] = (_dirty & (1UL << i)) ? _staged[i] : _shadow_reg(i);
+    _transfer(buffer, last - reg + 2, nullptr, 0);
+    bursts++;
+    reg = last + 1;
+  }
+
+  _dirty = 0;
+  return bursts;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the error of the bus accesses
+  @return first error since the previous call, DS3231_OK if none
+  @details Methods that fail on the bus return 0 or false values, check
+  lastError() after a sequence of calls to tell them from the real values.
+*/
+/**************************************************************************/
+DS3231_ERROR_t DS3231::lastError(void) {
+  DS3231_ERROR_t err = static_cast<DS3231_ERROR_t>(_error);
+  _error = DS3231_OK;
+  return err;
+}
+
+#ifdef DS3231_INSTRUMENTATION
+/**************************************************************************/
+/*!
+  @brief  Counters and trace of the driver
+  @details Only with DS3231_INSTRUMENTATION defined for the library, a
+  sketch that defines it alone fails to link.
+*/
+/**************************************************************************/
+DS3231Instrumentation& DS3231::instrumentation(void) {
+  return _instr;
+}
+#endif
+
+/**************************************************************************/
+/*!
+  @brief  Free a bus held by a device stuck in the middle of a byte
+  @param  sda SDA pin
+  @param  scl SCL pin
+  @return True if both lines are released
+  @details Clocks SCL until the device releases SDA (at most 9 clocks) and
+  generates a STOP. Wire has to be ended before and begun again after, e.g.
+  from the callback of onBusRecovery(). The lines are driven low or
+  released to their pull-ups, never driven high.
+*/
+/**************************************************************************/
+bool DS3231::recoverBus(uint8_t sda, uint8_t scl) {
+  pinMode(sda, INPUT_PULLUP);
+  pinMode(scl, INPUT_PULLUP);
+  for (uint8_t i = 0; i < 9 && digitalRead(sda) == LOW; i++) {
+    digitalWrite(scl, LOW);
+    pinMode(scl, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(scl, INPUT_PULLUP);
+    for (uint8_t stretch = 0; stretch < 100 && digitalRead(scl) == LOW; stretch++)
+      delayMicroseconds(10);  // clock stretching
+    delayMicroseconds(5);
+  }
+
+  // STOP: SDA rises while SCL is high
+  digitalWrite(sda, LOW);
+  pinMode(sda, OUTPUT);
+  delayMicroseconds(5);
+  pinMode(sda, INPUT_PULLUP);
+  delayMicroseconds(5);
+  return digitalRead(sda) == HIGH && digitalRead(scl) == HIGH;
 }
 
 /**************************************************************************/
@@ -364,17 +961,231 @@ bool DS3231::is32KEnabled(void) {
 */
 /**************************************************************************/
 int8_t DS3231::weekDay(int16_t yOff, int8_t m, int8_t d) {
-  const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+  return (_days(yOff, m, d) + 6) % 7; // Jan 1, 2000 is a Saturday, i.e. returns 6
+}
+
+static const char daysOfTheWeek[7][DS3231_DAY_SIZE] PROGMEM = {
+  "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"
+};
+
+/**************************************************************************/
+/*!
+  @brief  English name of a day of the week, stored in flash
+  @param wday Day of the week (0 to 6), tm_wday
+  @param buf buffer of DS3231_DAY_SIZE bytes for the name
+  @return buf, e.g. for Serial.print()
+*/
+/**************************************************************************/
+char* DS3231::dayOfTheWeek(uint8_t wday, char *buf) {
+  return strcpy_P(buf, daysOfTheWeek[wday % 7]);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Return the day of the year.
+  @param yOff Offset of the year from 2000, i.e. for 2024, it is 24
+  @param m Month (1 to 12)
+  @param d Day
+  @return Day of year from 0 (1 Jan) to 365, same as tm_yday
+*/
+/**************************************************************************/
+int16_t DS3231::dayOfYear(int16_t yOff, int8_t m, int8_t d) {
+  return _month_start(yOff, m - 1) + d - 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Convert a date/time to seconds since 2000/01/01 00:00:00
+  @param  dt DateTime object (tm_year as offset from 2000, tm_mon 1 to 12)
+  @return seconds since 2000/01/01 00:00:00, valid until 2136/02/07 06:28:15
+*/
+/**************************************************************************/
+uint32_t DS3231::toEpoch(const DateTime &dt) {
+  return _seconds(_days(dt.tm_year, dt.tm_mon, dt.tm_mday), dt.tm_hour, dt.tm_min, dt.tm_sec);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Convert seconds since 2000/01/01 00:00:00 to a date/time
+  @param  epoch seconds since 2000/01/01 00:00:00
+  @param  dt DateTime object for storing the date/time info, tm_wday and 
+  tm_yday are filled as well
+*/
+/**************************************************************************/
+void DS3231::fromEpoch(uint32_t epoch, DateTime *dt) {
+  _from_days(epoch / 86400L, epoch % 86400L, dt);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Convert days since 2000/01/01 and a second of the day to a date/time
+  @param  days days since 2000/01/01, until 2199/12/31
+  @param  secs second of the day (0 to 86399)
+  @param  dt DateTime object for storing the date/time info
+*/
+/**************************************************************************/
+void DS3231::_from_days(uint32_t days, uint32_t secs, DateTime *dt) {
+  dt->tm_sec = secs % 60;
+  dt->tm_min = (secs / 60) % 60;
+  dt->tm_hour = secs / 3600;
+  dt->tm_wday = (days + 6) % 7;
+
+  // days / 365 is never more than one year ahead for less than 365 leap days
+  int16_t yOff = days / 365;
+  if (days < _year_start(yOff))
+    --yOff;
+  int16_t yday = days - _year_start(yOff);
+
+  // yday / 32 is never more than one month behind
+  int8_t m = yday >> 5;
+  if (m < 11 && yday >= _month_start(yOff, m + 1))
+    ++m;
+
+  dt->tm_year = yOff;
+  dt->tm_mon = m + 1;
+  dt->tm_mday = yday - _month_start(yOff, m) + 1;
+  dt->tm_yday = yday;
+  dt->tm_isdst = 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Convert a date/time to Unix time (seconds since 1970/01/01 00:00:00)
+  @param  dt DateTime object (tm_year as offset from 2000, tm_mon 1 to 12)
+  @return Unix time, valid until 2106/02/07 06:28:15
+*/
+/**************************************************************************/
+uint32_t DS3231::toUnix(const DateTime &dt) {
+  return toEpoch(dt) + DS3231_UNIX_OFFSET;
+}
 
-  // calculate days since year 2000 (valid for year 2000 - 2099)
-  uint16_t days = d;
-  for (uint8_t i=0; i<m-1; ++i)
-    days += daysInMonth[i];
-  if (m > 2 && yOff % 4 == 0)
-    ++days;
-  days = days + 365 * yOff + (yOff + 3) / 4 - 1;
+/**************************************************************************/
+/*!
+  @brief  Convert Unix time to a date/time
+  @param  timestamp Unix time, not earlier than 2000/01/01 00:00:00
+  @param  dt DateTime object for storing the date/time info
+*/
+/**************************************************************************/
+void DS3231::fromUnix(uint32_t timestamp, DateTime *dt) {
+  fromEpoch(timestamp - DS3231_UNIX_OFFSET, dt);
+}
 
-  return (days + 6) % 7; // Jan 1, 2000 is a Saturday, i.e. returns 6
+/**************************************************************************/
+/*!
+  @brief  Add (or subtract) a duration to a date/time
+  @param  dt DateTime object to be modified
+  @param  seconds duration in seconds, negative to subtract
+  @details Computed on days and seconds of the day, valid for any result
+  between 2000/01/01 and 2199/12/31.
+*/
+/**************************************************************************/
+void DS3231::addSeconds(DateTime *dt, int32_t seconds) {
+  int32_t days = _days(dt->tm_year, dt->tm_mon, dt->tm_mday) + seconds / 86400L;
+  int32_t secs = (dt->tm_hour * 60L + dt->tm_min) * 60L + dt->tm_sec + seconds % 86400L;
+  if (secs < 0) {
+    secs += 86400L;
+    days--;
+  }
+  else if (secs >= 86400L) {
+    secs -= 86400L;
+    days++;
+  }
+  _from_days(days, secs, dt);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Difference between two date/time
+  @param  a DateTime object
+  @param  b DateTime object
+  @return a - b in seconds, valid for the years 2000 - 2199 when the
+  difference is within 68 years
+*/
+/**************************************************************************/
+int32_t DS3231::diffSeconds(const DateTime &a, const DateTime &b) {
+  int32_t days = static_cast<int32_t>(_days(a.tm_year, a.tm_mon, a.tm_mday) - _days(b.tm_year, b.tm_mon, b.tm_mday));
+  int32_t secs = ((a.tm_hour - b.tm_hour) * 60L + (a.tm_min - b.tm_min)) * 60L + (a.tm_sec - b.tm_sec);
+  return days * 86400L + secs;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the current time as seconds since 2000/01/01 00:00:00
+  @return seconds since 2000/01/01 00:00:00
+  @details Converted straight from the time registers without building a 
+  DateTime object.
+*/
+/**************************************************************************/
+uint32_t DS3231::epochNow() {
+  DS3231_PROBE(DS3231_METHOD_EPOCH_NOW);
+  uint8_t buffer[7]{0};
+  _read_register(DS3231_TIME, buffer, sizeof(buffer));
+
+  int16_t yOff = _bcd2bin(buffer[6]) + ((buffer[5] & 0x80) ? 100 : 0);  // msb of month = Century
+  int8_t m = _bcd2bin(buffer[5] & 0x1F);
+  uint32_t days = _days(yOff, m, _bcd2bin(buffer[4])) + (_past_2100_leap(yOff, m) ? 1 : 0);
+  return _seconds(days, _bcd2bin(buffer[2] & 0x3F), _bcd2bin(buffer[1]), _bcd2bin(buffer[0]));
+}
+
+// Days before the first day of each month in a non-leap year
+static const uint16_t cumulativeDays[] PROGMEM = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
+
+/**************************************************************************/
+/*!
+  @brief  Check leap year
+  @param yOff Offset of the year from 2000
+  @return True for a leap year
+*/
+/**************************************************************************/
+bool DS3231::_is_leap(int16_t yOff) {
+  return (yOff % 4 == 0) && ((yOff % 100 != 0) || ((yOff + 2000) % 400 == 0));
+}
+
+/**************************************************************************/
+/*!
+  @brief  Days from 2000/01/01 to the first day of a year
+  @param yOff Offset of the year from 2000 (0 to 199)
+  @return days since 2000/01/01
+*/
+/**************************************************************************/
+uint32_t DS3231::_year_start(int16_t yOff) {
+  // leap days of the years before, 2000 is a leap year but 2100 is not
+  return 365L * yOff + (yOff + 3) / 4 - (yOff + 99) / 100 + (yOff + 399) / 400;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Days from the first day of the year to the first day of a month
+  @param yOff Offset of the year from 2000
+  @param m Month index (0 to 11)
+  @return days since the first day of the year
+*/
+/**************************************************************************/
+uint16_t DS3231::_month_start(int16_t yOff, int8_t m) {
+  return pgm_read_word(&cumulativeDays[m]) + ((m > 1 && _is_leap(yOff)) ? 1 : 0);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Days since 2000/01/01
+  @param yOff Offset of the year from 2000, i.e. for 2024, it is 24
+  @param m Month (1 to 12)
+  @param d Day
+  @return days since 2000/01/01 (valid for year 2000 - 2199)
+*/
+/**************************************************************************/
+uint32_t DS3231::_days(int16_t yOff, int8_t m, int8_t d) {
+  return _year_start(yOff) + _month_start(yOff, m - 1) + d - 1;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Combine days and time of the day
+  @return seconds since 2000/01/01 00:00:00
+*/
+/**************************************************************************/
+uint32_t DS3231::_seconds(uint32_t days, uint8_t hour, uint8_t minute, uint8_t second) {
+  return ((days * 24 + hour) * 60 + minute) * 60 + second;
 }
 
 /**************************************************************************/
@@ -383,60 +1194,278 @@ int8_t DS3231::weekDay(int16_t yOff, int8_t m, int8_t d) {
   @param  d __DATE__ 
   @param  t __TIME__
   @param  dt DateTime object for storing the date/time info
+  @details DS3231_BUILD_EPOCH gives the same time as a compile-time constant.
 */
 /**************************************************************************/
 void DS3231::getDateTime(const char* d, const char* t, DateTime* dt) {
+  fromEpoch(ds3231_build_epoch(d, t), dt);
+}
 
-  const char* month_name[] = {
-      "Jan", "Feb", "Mar", "Apr", "May", "Jun",
-      "Jul", "Aug", "Sep", "Oct", "Nov", "Dev"
-  };
+/**************************************************************************/
+/*!
+  @brief  Get date and time from a preset char array "2024/04/02 12:08:00"
+  @param  ts pointer to the char array, it is not modified
+  @param  dt DateTime object for storing the date/time info
+  @return True if ts is a valid date/time, see parse()
+*/
+/**************************************************************************/
+bool DS3231::getDateTime(const char* ts, DateTime* dt) {
+  return parse(ts, strlen(ts), dt);
+}
+
+// Parse 1 to max digits, nullptr if there is none
+static const char* parseNumber(const char *p, const char *end, uint8_t max, uint16_t *val) {
+  const char *start = p;
+  *val = 0;
+  while (p < end && p - start < max && *p >= '0' && *p <= '9')
+    *val = *val * 10 + (*p++ - '0');
+  return (p == start) ? nullptr : p;
+}
+
+// Parse a separator followed by 1 or 2 digits
+static const char* parseField(const char *p, const char *end, char sep, uint16_t *val) {
+  return (p < end && *p == sep) ? parseNumber(p + 1, end, 2, val) : nullptr;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Parse a date/time in a single pass, without copying or modifying
+  the text
+  @param  s text, does not need to be '\0' terminated
+  @param  len length of the text
+  @param  dt DateTime object for storing the date/time info, unchanged when
+  the text is invalid
+  @return True if the text is a valid date/time of the years 2000 - 2199
+  @details Accepts "2024-04-02T12:08:00" (ISO 8601) and "2024/04/02 12:08:00".
+  The seconds and the time are optional, a fraction of the seconds is
+  ignored, trailing white space is allowed. A time with a "Z" or a "+hh:mm"
+  / "-hh:mm" zone is converted to UTC.
+*/
+/**************************************************************************/
+bool DS3231::parse(const char *s, size_t len, DateTime *dt) {
+  const char *end = s + len;
+  uint16_t year, month, day, hour = 0, minute = 0, second = 0;
+  int32_t zone = 0;
 
-  // parse date from __DATE__
-  char dstr[12]{0};    
-  memcpy(dstr, d, 12);
-  char* mon = strtok(dstr, " ");
-  dt->tm_mday = atoi(strtok(NULL, " "));
-  dt->tm_year = atoi(strtok(NULL, " ")) - 2000;
-  for (int i=0; i<12; i++) {
-      if (strcmp(month_name[i], mon) == 0) {
-          dt->tm_mon = i;
-          break;
+  const char *p = parseNumber(s, end, 4, &year);
+  if (!p || p - s != 4 || p == end || (*p != '-' && *p != '/'))
+    return false;
+  char sep = *p;
+  if (!(p = parseField(p, end, sep, &month)) || !(p = parseField(p, end, sep, &day)))
+    return false;
+
+  if (p < end && (*p == 'T' || *p == ' ') && p + 1 < end && p[1] >= '0' && p[1] <= '9') {
+    if (!(p = parseNumber(p + 1, end, 2, &hour)) || !(p = parseField(p, end, ':', &minute)))
+      return false;
+    if (p < end && *p == ':' && !(p = parseField(p, end, ':', &second)))
+      return false;
+    if (p < end && (*p == '.' || *p == ',')) {
+      while (++p < end && *p >= '0' && *p <= '9');
+    }
+    if (p < end && *p == 'Z') {
+      p++;
+    }
+    else if (p < end && (*p == '+' || *p == '-')) {
+      uint16_t zh, zm = 0;
+      const char *q = parseNumber(p + 1, end, 2, &zh);
+      if (!q || q - p != 3 || zh > 23)
+        return false;
+      if (q < end && *q == ':')
+        q++;
+      if (q < end && *q >= '0' && *q <= '9') {
+        const char *r = parseNumber(q, end, 2, &zm);
+        if (r - q != 2 || zm > 59)
+          return false;
+        q = r;
       }
+      zone = (zh * 60L + zm) * 60L * ((*p == '-') ? -1 : 1);
+      p = q;
+    }
   }
-  
-  // parse time from __TIME__
-  char tstr[9]{0};
-  memcpy(tstr, t, 9);
-  dt->tm_hour = atoi(strtok(tstr, ":"));
-  dt->tm_min = atoi(strtok(NULL, ":"));
-  dt->tm_sec = atoi(strtok(NULL, ":"));
+  while (p < end && (*p == ' ' || *p == '\r' || *p == '\n' || *p == '\t'))
+    p++;
+  if (p != end)
+    return false;
 
-  // calculate day of the week
-  dt->tm_wday = weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday);
+  if (year < 2000 || year > 2199 || month < 1 || month > 12 || day < 1 ||
+      hour > 23 || minute > 59 || second > 59)
+    return false;
+  int16_t yOff = year - 2000;
+  if (day > _month_start(yOff, month) - _month_start(yOff, month - 1))
+    return false;
+
+  DateTime parsed{};
+  parsed.tm_year = yOff;
+  parsed.tm_mon = month;
+  parsed.tm_mday = day;
+  parsed.tm_hour = hour;
+  parsed.tm_min = minute;
+  parsed.tm_sec = second;
+  parsed.tm_wday = weekDay(yOff, month, day);
+  parsed.tm_yday = dayOfYear(yOff, month, day);
+  if (zone) {
+    // converted to UTC on days and seconds of the day, valid until 2199
+    int32_t utc = (hour * 60L + minute) * 60L + second - zone;
+    if ((utc < 0 && _days(yOff, month, day) == 0) || (utc >= 86400L && yOff == 199 && month == 12 && day == 31))
+      return false;
+    addSeconds(&parsed, -zone);
+  }
+  *dt = parsed;
+  return true;
+}
+
+static char* formatNumber(char *p, uint16_t val, uint8_t digits) {
+  for (uint8_t i = digits; i > 0; i--) {
+    p[i - 1] = '0' + val % 10;
+    val /= 10;
+  }
+  return p + digits;
 }
 
 /**************************************************************************/
 /*!
-  @brief  Get date and time from a preset char array "2024/04/02 12:08:00"
-  @param  ts pointer to the char array
-  @param  dt DateTime object for storing the date/time info
+  @brief  Format a date/time into a buffer, without printf
+  @param  buf buffer of DS3231_FORMAT_SIZE bytes or less for a shorter format
+  @param  size size of the buffer
+  @param  dt DateTime object
+  @param  fmt DS3231_FORMAT_ISO8601, DS3231_FORMAT_DATETIME, DS3231_FORMAT_DATE
+  or DS3231_FORMAT_TIME
+  @return length of the text without the '\0', 0 if the buffer is too small
 */
 /**************************************************************************/
-void DS3231::getDateTime(char * ts, DateTime* dt) { 
-  // parse date and time from ts c-string
-  dt->tm_year = atoi(strtok(ts, "/: ")) - 2000;
-  dt->tm_mon = atoi(strtok(NULL, "/: "));
-  dt->tm_mday = atoi(strtok(NULL, "/: "));
-  dt->tm_hour = atoi(strtok(NULL, "/: "));
-  dt->tm_min = atoi(strtok(NULL, "/: "));
-  dt->tm_sec = atoi(strtok(NULL, "/: "));
+uint8_t DS3231::format(char *buf, size_t size, const DateTime &dt, DS3231_FORMAT_t fmt) {
+  uint8_t len = (fmt == DS3231_FORMAT_DATE) ? 10 : (fmt == DS3231_FORMAT_TIME) ? 8 : 19;
+  if (size <= len) {
+    if (size)
+      buf[0] = '\0';
+    return 0;
+  }
 
-  // calculate day of the week
-  dt->tm_wday = weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday);
+  char *p = buf;
+  char sep = (fmt == DS3231_FORMAT_DATETIME) ? '/' : '-';
+  if (fmt != DS3231_FORMAT_TIME) {
+    p = formatNumber(p, 2000 + dt.tm_year, 4);
+    *p++ = sep;
+    p = formatNumber(p, dt.tm_mon, 2);
+    *p++ = sep;
+    p = formatNumber(p, dt.tm_mday, 2);
+    if (fmt != DS3231_FORMAT_DATE)
+      *p++ = (fmt == DS3231_FORMAT_ISO8601) ? 'T' : ' ';
+  }
+  if (fmt != DS3231_FORMAT_DATE) {
+    p = formatNumber(p, dt.tm_hour, 2);
+    *p++ = ':';
+    p = formatNumber(p, dt.tm_min, 2);
+    *p++ = ':';
+    p = formatNumber(p, dt.tm_sec, 2);
+  }
+  *p = '\0';
+  return len;
+}
+
+/**************************************************************************/
+/*!
+  @brief Load the shadow registers
+  @param regs registers 0x07 (ALARM1) to 0x0F (STATUS) as read from the chip
+*/
+/**************************************************************************/
+void DS3231::_load_shadow(const uint8_t *regs) {
+  memcpy(_shadow, regs, sizeof(_shadow));
+  _shadow_reg(DS3231_CONTROL) &= ~(1 << DS3231_CONTROL_CONV);  // never re-trigger a conversion
+  // keep the flag bits at 1 so writing the shadow back leaves them unchanged
+  _shadow_reg(DS3231_STATUS) = (_shadow_reg(DS3231_STATUS) & (1 << DS3231_STATUS_EN32KHZ)) | DS3231_STATUS_FLAGS;
+}
+
+/**************************************************************************/
+/*!
+  @brief Get CONTROL register, from the shadow when it is enabled
+  @return value of the CONTROL register
+*/
+/**************************************************************************/
+uint8_t DS3231::_read_control(void) {
+  return _shadowed ? _shadow_reg(DS3231_CONTROL) : _read_register(DS3231_CONTROL);
+}
+
+/**************************************************************************/
+/*!
+  @brief Get STATUS register for its configuration bit (EN32KHZ), from the 
+  shadow when it is enabled. Do not use it for the status flags.
+  @return value of the STATUS register
+*/
+/**************************************************************************/
+uint8_t DS3231::_read_status_config(void) {
+  return _shadowed ? _shadow_reg(DS3231_STATUS) : _read_register(DS3231_STATUS);
+}
+
+/**************************************************************************/
+/*!
+  @brief STATUS register to be modified with the shadow registers enabled
+  @return the value staged by the current transaction, so that a flag it
+  cleared stays cleared, otherwise the shadow with the flag bits at 1
+*/
+/**************************************************************************/
+uint8_t DS3231::_shadow_status(void) {
+  if (_transaction && (_dirty & (1UL << DS3231_STATUS)))
+    return _staged[DS3231_STATUS];
+  return _shadow_reg(DS3231_STATUS);
+}
+
+/**************************************************************************/
+/*!
+  @brief Modify bits of CONTROL register
+  @param mask bits to be modified
+  @param bits new value of the masked bits
+*/
+/**************************************************************************/
+void DS3231::_update_control(uint8_t mask, uint8_t bits) {
+  if (_shadowed) {
+    _shadow_reg(DS3231_CONTROL) = (_shadow_reg(DS3231_CONTROL) & ~mask) | bits;
+    _write_register(DS3231_CONTROL, _shadow_reg(DS3231_CONTROL));
+    return;
+  }
+  uint8_t ctrl = _read_register(DS3231_CONTROL);
+  _write_register(DS3231_CONTROL, (ctrl & ~mask) | bits);
+}
 
+/**************************************************************************/
+/*!
+  @brief Modify bits of STATUS register
+  @param mask bits to be modified, a flag bit in the mask with bits value 0
+  clears the flag
+  @param bits new value of the masked bits
+  @details The flags outside the mask are written as 1, which leaves them
+  unchanged: a flag set by the chip between the read and the write (e.g.
+  while the write is staged by a transaction) is not cleared. A STATUS
+  already staged keeps the flags its earlier writes cleared.
+*/
+/**************************************************************************/
+void DS3231::_update_status(uint8_t mask, uint8_t bits) {
+  if (_shadowed) {
+    uint8_t status = (_shadow_status() & ~mask) | bits;
+    _write_register(DS3231_STATUS, status);
+    _shadow_reg(DS3231_STATUS) = status | DS3231_STATUS_FLAGS;
+    return;
+  }
+  // a staged STATUS already holds the flags to clear as 0 and the others as 1
+  uint8_t keep = (_transaction && (_dirty & (1UL << DS3231_STATUS))) ? 0 : (DS3231_STATUS_FLAGS & ~mask);
+  uint8_t status = _read_register(DS3231_STATUS);
+  _write_register(DS3231_STATUS, (status & ~mask) | bits | keep);
 }
 
+/**************************************************************************/
+/*!
+  @brief Write a range of shadow registers to the chip in one transaction
+  @param first first register address
+  @param last last register address
+*/
+/**************************************************************************/
+void DS3231::_write_shadow(uint8_t first, uint8_t last) {
+  uint8_t buffer[sizeof(_shadow) + 1];
+  uint8_t len = last - first + 1;
+  buffer[0] = first;
+  memcpy(&buffer[1], &_shadow_reg(first), len);
+  _write_register(buffer, len + 1);
+}
 
 /**************************************************************************/
 /*!
@@ -446,9 +1475,11 @@ void DS3231::getDateTime(char * ts, DateTime* dt) {
 */
 /**************************************************************************/
 void DS3231::_write_register(uint8_t *buf, uint8_t len) {
-  _wire->beginTransmission(DS3231_ADDRESS);
-  _wire->write(buf, len);
-  _wire->endTransmission();
+  if (_transaction) {
+    _stage(buf[0], &buf[1], len - 1);
+    return;
+  }
+  _transfer(buf, len, nullptr, 0);
 }
 
 /**************************************************************************/
@@ -460,9 +1491,7 @@ void DS3231::_write_register(uint8_t *buf, uint8_t len) {
 /**************************************************************************/
 void DS3231::_write_register(uint8_t reg, uint8_t val) {
   uint8_t buffer[2] = {reg, val};
-  _wire->beginTransmission(DS3231_ADDRESS);
-  _wire->write(buffer, 2);
-  _wire->endTransmission();
+  _write_register(buffer, 2);
 }
 
 /**************************************************************************/
@@ -473,15 +1502,11 @@ void DS3231::_write_register(uint8_t reg, uint8_t val) {
 */
 /**************************************************************************/
 uint8_t DS3231::_read_register(uint8_t reg) {
-  _wire->beginTransmission(DS3231_ADDRESS);
-  _wire->write(reg);
-  _wire->endTransmission(false);
+  if (_transaction && (_dirty & (1UL << reg)))
+    return _staged[reg];
 
   uint8_t data{0};
-  _wire->requestFrom(DS3231_ADDRESS, 1);
-  while(_wire->available())
-    data = _wire->read();
-
+  _transfer(&reg, 1, &data, 1);
   return data;
 }
 
@@ -490,18 +1515,180 @@ uint8_t DS3231::_read_register(uint8_t reg) {
   @brief Read a value from register.
   @param reg register address
   @param data pointer to received data buffer
-  @return len length of the data to be received
+  @param len length of the data to be received
+  @return len, or 0 if the read failed
 */
 /**************************************************************************/
 uint8_t DS3231::_read_register(uint8_t reg, uint8_t *data, uint8_t len) {
-  _wire->beginTransmission(DS3231_ADDRESS);
-  _wire->write(reg);
-  _wire->endTransmission(false);
+  if (_transfer(&reg, 1, data, len))
+    return 0;
 
-  int i = 0;
-  _wire->requestFrom(DS3231_ADDRESS, len);
-  while(_wire->available())
-    data[i++] = _wire->read();
+  // a transaction reads its own pending writes
+  for (uint8_t i = 0; _transaction && _dirty && i < len; i++) {
+    if (_dirty & (1UL << (reg + i)))
+      data[i] = _staged[reg + i];
+  }
 
   return len;
 }
+
+/**************************************************************************/
+/*!
+  @brief One I2C transaction with the bus lock held, retried on failure
+  @param wbuf bytes to be written, register address first
+  @param wlen number of bytes to be written
+  @param rbuf buffer for the bytes read after a repeated START
+  @param rlen number of bytes to be read, 0 for a write
+  @return 0, or a DS3231_ERROR_t code once the retries are exhausted
+  @details The bus recovery callback is called before retrying after a
+  timeout or a bus error. The first error is kept for lastError().
+*/
+/**************************************************************************/
+uint8_t DS3231::_transfer(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  uint32_t start = micros();
+  _stats.transactions++;
+
+  uint8_t err = DS3231_OK;
+  if (_lock && !_lock->lock(DS3231_LOCK_TIMEOUT_US)) {
+    _stats.lock_timeouts++;
+    err = DS3231_ERR_LOCK;
+  }
+  else {
+    uint32_t wait = micros() - start;
+    if (wait > DS3231_LOCK_CONTENDED_US)
+      _stats.contended++;
+    if (wait > _stats.lock_wait_max)
+      _stats.lock_wait_max = wait;
+
+    for (uint8_t attempt = 0; ; attempt++) {
+      err = _attempt(wbuf, wlen, rbuf, rlen);
+      if (err == DS3231_OK || err == DS3231_ERR_TOO_LONG || attempt >= _retries)
+        break;
+      if (_recovery && (err == DS3231_ERR_TIMEOUT || err == DS3231_ERR_OTHER)) {
+        _recovery();
+        _stats.recoveries++;
+      }
+      _stats.retries++;
+      delayMicroseconds(DS3231_RETRY_DELAY_US);
+    }
+    if (_lock)
+      _lock->unlock();
+  }
+
+  uint32_t latency = micros() - start;
+#ifdef DS3231_INSTRUMENTATION
+  _instr.transaction(wbuf[0], wlen, rlen, err, start, latency);
+#endif
+  _stats.latency_total += latency;
+  if (latency > _stats.latency_max)
+    _stats.latency_max = latency;
+  if (err) {
+    _stats.errors++;
+    if (_error == DS3231_OK)
+      _error = err;
+  }
+  return err;
+}
+
+/**************************************************************************/
+/*!
+  @brief One attempt of a transaction, never waits more than the Wire timeout
+  @return 0 or a DS3231_ERROR_t code
+*/
+/**************************************************************************/
+uint8_t DS3231::_attempt(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  _wire->beginTransmission(DS3231_ADDRESS);
+  if (_wire->write(wbuf, wlen) != wlen) {
+    _wire->endTransmission();
+    return DS3231_ERR_TOO_LONG;
+  }
+  uint8_t err = _wire->endTransmission(rlen == 0);
+  if (err || rlen == 0)
+    return err;
+
+  uint8_t i = 0;
+  uint8_t received = _wire->requestFrom(DS3231_ADDRESS, rlen);
+  while (_wire->available() && i < rlen)
+    rbuf[i++] = _wire->read();
+  return (received == rlen && i == rlen) ? DS3231_OK : DS3231_ERR_READ;
+}
+
+/**************************************************************************/
+/*!
+  @brief Stage register values in a transaction
+  @param reg first register address
+  @param val pointer to the values
+  @param len number of values
+*/
+/**************************************************************************/
+void DS3231::_stage(uint8_t reg, const uint8_t *val, uint8_t len) {
+  for (uint8_t i = 0; i < len && reg + i < DS3231_TEMPERATURE; i++) {
+    _staged[reg + i] = val[i];
+    _dirty |= 1UL << (reg + i);
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief Check if a register that is not staged can be written as part of
+  a burst, i.e. its value is known from the shadow
+  @param reg register address
+  @return True if the register can be written
+*/
+/**************************************************************************/
+bool DS3231::_fillable(uint8_t reg) {
+  return _shadowed && reg >= DS3231_ALARM1 && reg <= DS3231_STATUS;
+}
+
+
+/**************************************************************************/
+/*!
+  @brief  Get the date/time of the snapshot
+  @return DateTime object
+*/
+/**************************************************************************/
+DateTime DS3231Snapshot::now() const {
+  return DS3231::_decode_time(&reg[DS3231_TIME]);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get Alarm 1 setting of the snapshot
+  @param  dt Pointer to an empty DateTime object
+  @return alarm mode, see DS3231::getAlarm1Status()
+*/
+/**************************************************************************/
+DS3231_ALARM1_t DS3231Snapshot::alarm1(DateTime *dt) const {
+  return DS3231::_decode_alarm1(&reg[DS3231_ALARM1], &reg[DS3231_TIME + 5], dt);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get Alarm 2 setting of the snapshot
+  @param  dt Pointer to an empty DateTime object
+  @return alarm mode, see DS3231::getAlarm2Status()
+*/
+/**************************************************************************/
+DS3231_ALARM2_t DS3231Snapshot::alarm2(DateTime *dt) const {
+  return DS3231::_decode_alarm2(&reg[DS3231_ALARM2], &reg[DS3231_TIME + 5], dt);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the temperature of the snapshot
+  @return temperature (float)
+*/
+/**************************************************************************/
+float DS3231Snapshot::temperature() const {
+  return temperatureRaw() * 0.25f;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the temperature of the snapshot without floating point
+  @return temperature in signed Q8.2 fixed point (quarter degrees)
+*/
+/**************************************************************************/
+int16_t DS3231Snapshot::temperatureRaw() const {
+  return DS3231::_decode_temperature(&reg[DS3231_TEMPERATURE]);
+}
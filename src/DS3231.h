@@ -3,6 +3,9 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <time.h>
+#ifdef DS3231_INSTRUMENTATION
+#include "DS3231Instrumentation.h"
+#endif
 
 #define DS3231_ADDRESS        0x68  // I2C address for DS3231
 
@@ -12,17 +15,37 @@
 #define DS3231_ALARM2         0x0B
 #define DS3231_CONTROL        0x0E
 #define DS3231_STATUS         0x0F
+#define DS3231_AGING          0x10
 #define DS3231_TEMPERATURE    0x11  // Temperature register (high byte - low byte is at 0x12), 10-bit temperature value
+#define DS3231_REGISTERS      19    // Number of registers (0x00 - 0x12)
+
+#define DS3231_UNIX_OFFSET    946684800UL  // Unix time of 2000/01/01 00:00:00
+#define DS3231_COMMIT_GAP     2     // unstaged registers bridged by commit() to save a transaction
+#define DS3231_ALIGN_MARGIN_US  2000  // least time before the second boundary targeted by adjustAligned()
+
+#define DS3231_RETRIES             2      // default retries of a failed transaction
+#define DS3231_RETRY_DELAY_US      100    // pause before a retry
+#define DS3231_LOCK_TIMEOUT_US     10000  // longest wait for the bus lock
+#define DS3231_LOCK_CONTENDED_US   20     // a longer wait for the lock counts as contended
+#define DS3231_WIRE_TIMEOUT_US     25000  // Wire timeout, on the cores that support it (WIRE_HAS_TIMEOUT)
 
 // DS3231 Register Bit Position
 #define DS3231_CONTROL_ALARM1_INT_EN 0
 #define DS3231_CONTROL_ALARM2_INT_EN 1
 #define DS3231_CONTROL_INTCON        2
 #define DS3231_CONTROL_RS            3
+#define DS3231_CONTROL_CONV          5
+#define DS3231_CONTROL_BBSQW         6
+#define DS3231_STATUS_ALARM1_FLAG    0
+#define DS3231_STATUS_ALARM2_FLAG    1
+#define DS3231_STATUS_BUSY           2
 #define DS3231_STATUS_EN32KHZ        3
 #define DS3231_STATUS_OSC_STOP       7
 
-const char daysOfTheWeek[7][12] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+// Status flags that are only cleared by writing 0, writing 1 leaves them unchanged
+#define DS3231_STATUS_FLAGS   ((1 << DS3231_STATUS_OSC_STOP) | (1 << DS3231_STATUS_ALARM2_FLAG) | (1 << DS3231_STATUS_ALARM1_FLAG))
+
+#define DS3231_DAY_SIZE       10    // buffer size for dayOfTheWeek(), "Wednesday" and the '\0'
 
 typedef enum {
     DS3231_SQW_1HZ    = (0 << DS3231_CONTROL_RS),
@@ -49,18 +72,127 @@ typedef enum {
   DS3231_ALARM1_ON_WEEKDAY   = 0x10   /* Alarm when day (day of week), hours, minutes and seconds match */
 } DS3231_ALARM1_t;
 
+// Error codes of lastError(), 1 - 5 are the codes of Wire endTransmission()
+typedef enum {
+  DS3231_OK               = 0,
+  DS3231_ERR_TOO_LONG     = 1,  /* data too long for the Wire buffer */
+  DS3231_ERR_NACK_ADDRESS = 2,  /* NACK on the address, no device */
+  DS3231_ERR_NACK_DATA    = 3,  /* NACK on a data byte */
+  DS3231_ERR_OTHER        = 4,  /* other bus error, e.g. lost arbitration */
+  DS3231_ERR_TIMEOUT      = 5,  /* bus timeout, e.g. SCL held low */
+  DS3231_ERR_READ         = 6,  /* fewer bytes received than requested */
+  DS3231_ERR_LOCK         = 7   /* the bus lock was not acquired in time */
+} DS3231_ERROR_t;
+
+// Bus usage of a DS3231 object, see DS3231::busStats()
+typedef struct {
+  uint32_t transactions;
+  uint32_t errors;          // transactions failed after all the retries
+  uint32_t retries;
+  uint32_t recoveries;      // calls of the bus recovery callback
+  uint32_t lock_timeouts;
+  uint32_t contended;       // transactions that waited for the lock
+  uint32_t lock_wait_max;   // micros
+  uint32_t latency_max;     // micros of a transaction, including the lock and the retries
+  uint32_t latency_total;
+} DS3231BusStats_t;
+
 typedef struct tm DateTime;
 
+// Text formats of DS3231::format()
+typedef enum {
+  DS3231_FORMAT_ISO8601,   /* 2024-04-02T12:08:00 */
+  DS3231_FORMAT_DATETIME,  /* 2024/04/02 12:08:00 */
+  DS3231_FORMAT_DATE,      /* 2024-04-02 */
+  DS3231_FORMAT_TIME       /* 12:08:00 */
+} DS3231_FORMAT_t;
+
+#define DS3231_FORMAT_SIZE    20    // buffer size for any DS3231_FORMAT_t, including the '\0'
+
+// Compile-time parsing of __DATE__ ("Apr  2 2024") and __TIME__ ("12:08:00")
+constexpr uint8_t ds3231_digit(char c) { return (c >= '0' && c <= '9') ? static_cast<uint8_t>(c - '0') : 0; }
+constexpr uint8_t ds3231_2digits(const char *s) { return ds3231_digit(s[0]) * 10 + ds3231_digit(s[1]); }
+constexpr uint8_t ds3231_month(const char *m) {
+  return (m[0] == 'J') ? ((m[1] == 'a') ? 1 : (m[2] == 'n') ? 6 : 7) :
+         (m[0] == 'F') ? 2 :
+         (m[0] == 'M') ? ((m[2] == 'r') ? 3 : 5) :
+         (m[0] == 'A') ? ((m[1] == 'p') ? 4 : 8) :
+         (m[0] == 'S') ? 9 :
+         (m[0] == 'O') ? 10 :
+         (m[0] == 'N') ? 11 : 12;
+}
+constexpr bool ds3231_is_leap(uint16_t yOff) {
+  return (yOff % 4 == 0) && ((yOff % 100 != 0) || ((yOff + 2000) % 400 == 0));
+}
+// days since 2000/01/01, 275 * m / 9 - 30 is the days before the month m plus 2 (1 in a leap year) after February
+constexpr uint32_t ds3231_days(uint16_t yOff, uint8_t m, uint8_t d) {
+  return 365UL * yOff + (yOff + 3) / 4 - (yOff + 99) / 100 + (yOff + 399) / 400 +
+         275U * m / 9 - 30 - ((m > 2) ? (ds3231_is_leap(yOff) ? 1 : 2) : 0) + d - 1;
+}
+constexpr uint32_t ds3231_build_epoch(const char *d, const char *t) {
+  return ((ds3231_days(ds3231_digit(d[9]) * 10 + ds3231_digit(d[10]) + ds3231_digit(d[8]) * 100, ds3231_month(d), ds3231_2digits(d + 4)) * 24 +
+           ds3231_2digits(t)) * 60 + ds3231_2digits(t + 3)) * 60 + ds3231_2digits(t + 6);
+}
+
+// Seconds since 2000/01/01 00:00:00 of the compilation of the sketch, a constant (until 2136)
+#define DS3231_BUILD_EPOCH    ds3231_build_epoch(__DATE__, __TIME__)
+
+typedef void (*DS3231AlarmCallback_t)(uint8_t alarm_num);
+
+// Called when the bus is stuck, e.g. end Wire, DS3231::recoverBus() and begin Wire again
+typedef void (*DS3231BusRecovery_t)(void);
+
+// Mutual exclusion on a bus shared with other drivers or threads, e.g. a
+// FreeRTOS mutex. Each transaction is done with the lock held.
+class DS3231BusLock
+{
+public:
+  virtual ~DS3231BusLock() {}
+  virtual bool lock(uint32_t timeout_us) = 0;  // false when it times out
+  virtual void unlock(void) = 0;
+};
+
+// Raw copy of all the registers read in a single burst by DS3231::snapshot()
+class DS3231Snapshot
+{
+public:
+  uint8_t reg[DS3231_REGISTERS];
+
+  DateTime now() const;
+  DS3231_ALARM1_t alarm1(DateTime *dt) const;
+  DS3231_ALARM2_t alarm2(DateTime *dt) const;
+  float temperature() const;
+  int16_t temperatureRaw() const;
+  uint8_t control() const { return reg[DS3231_CONTROL]; }
+  uint8_t status() const { return reg[DS3231_STATUS]; }
+  int8_t aging() const { return static_cast<int8_t>(reg[DS3231_AGING]); }
+  bool lostPower() const { return reg[DS3231_STATUS] >> DS3231_STATUS_OSC_STOP; }
+  bool alarmFired(uint8_t alarm_num) const { return (reg[DS3231_STATUS] >> (alarm_num - 1)) & 0x1; }
+  bool isAlarmArmed(uint8_t alarm_num) const { return (reg[DS3231_CONTROL] >> (alarm_num - 1)) & 0x1; }
+  bool is32KEnabled() const { return (reg[DS3231_STATUS] >> DS3231_STATUS_EN32KHZ) & 0x01; }
+};
+
+template <typename Bus, uint8_t Address, uint8_t Features> class DS3231T;
+
 class DS3231
 {
 public:
   bool begin(TwoWire *wire, uint32_t speed=400000);
   bool lostPower(void);
   void adjust(const DateTime &dt);
+  int32_t adjustAligned(uint32_t epoch, uint32_t usec, uint32_t captured);
+  uint32_t alignLatency(void) const { return _align_latency; }
   DateTime now();
+  uint32_t epochNow();
+  DS3231Snapshot snapshot();
   DS3231_SQW_RATE_t readSquareWaveRate();
   void setSquareWaveRate(DS3231_SQW_RATE_t rate);
   float getTemperature();
+  int16_t getTemperatureRaw(bool *busy = nullptr);
+  bool startConversion(void);
+  bool isConverting(void);
+  int8_t getAgingOffset(void);
+  bool setAgingOffset(int8_t offset);
   void setAlarm1(const DateTime *dt, DS3231_ALARM1_t alarm_mode);
   void setAlarm2(const DateTime *dt, DS3231_ALARM2_t alarm_mode);
   DS3231_ALARM1_t getAlarm1Status(DateTime *dt);
@@ -69,22 +201,106 @@ public:
   void clearAlarm(uint8_t alarm_num);
   void disableAlarm(uint8_t alarm_num);
   bool alarmFired(uint8_t alarm_num);
+  void onAlarm(uint8_t alarm_num, DS3231AlarmCallback_t callback);
+  void notify(void);
+  bool isPending(void) const { return _pending; }
+  uint8_t service(void);
+  uint32_t latency(void) const { return _latency; }
+  uint32_t maxLatency(void) const { return _latency_max; }
   void enable32K(void);
   void disable32K(void);
   bool is32KEnabled(void);
-  int8_t weekDay(int16_t yOff, int8_t m, int8_t d);
-  void getDateTime(const char* d, const char* t, DateTime* dt);
-  void getDateTime(char* ts, DateTime* dt);
+  void enableBBSQW(void);
+  void disableBBSQW(void);
+  void enableShadow(void);
+  void disableShadow(void);
+  void resync(void);
+  void beginTransaction(void);
+  uint8_t commit(void);
+  DS3231_ERROR_t lastError(void);
+  void setBusLock(DS3231BusLock *lock) { _lock = lock; }
+  void setRetries(uint8_t retries) { _retries = retries; }
+  void onBusRecovery(DS3231BusRecovery_t recovery) { _recovery = recovery; }
+  const DS3231BusStats_t& busStats(void) const { return _stats; }
+  void resetBusStats(void) { _stats = DS3231BusStats_t{}; }
+#ifdef DS3231_INSTRUMENTATION
+  DS3231Instrumentation& instrumentation(void);
+#endif
+  static bool recoverBus(uint8_t sda, uint8_t scl);
+  static int8_t weekDay(int16_t yOff, int8_t m, int8_t d);
+  static char* dayOfTheWeek(uint8_t wday, char *buf);
+  static int16_t dayOfYear(int16_t yOff, int8_t m, int8_t d);
+  static uint32_t toEpoch(const DateTime &dt);
+  static void fromEpoch(uint32_t epoch, DateTime *dt);
+  static uint32_t toUnix(const DateTime &dt);
+  static void fromUnix(uint32_t timestamp, DateTime *dt);
+  static void addSeconds(DateTime *dt, int32_t seconds);
+  static int32_t diffSeconds(const DateTime &a, const DateTime &b);
+  static bool parse(const char *s, size_t len, DateTime *dt);
+  static uint8_t format(char *buf, size_t size, const DateTime &dt, DS3231_FORMAT_t fmt = DS3231_FORMAT_ISO8601);
+  static void getDateTime(const char* d, const char* t, DateTime* dt);
+  static bool getDateTime(const char* ts, DateTime* dt);
 
 private:
     TwoWire* _wire;
+    bool _shadowed{false};
+    uint8_t _shadow[9]{0};  // write-through copy of registers 0x07 (ALARM1) to 0x0F (STATUS)
+    DS3231AlarmCallback_t _callbacks[2]{nullptr, nullptr};
+    volatile bool _pending{false};
+    volatile uint32_t _notified{0};   // micros() when notify() was called
+    uint32_t _latency{0};             // micros from notify() to the first callback
+    uint32_t _latency_max{0};
+    uint8_t _transaction{0};              // nesting level of beginTransaction()
+    uint8_t _staged[DS3231_TEMPERATURE]{0};  // registers 0x00 - 0x10 written in a transaction
+    uint32_t _dirty{0};                   // bit mask of the staged registers
+    DS3231BusLock *_lock{nullptr};
+    DS3231BusRecovery_t _recovery{nullptr};
+    uint8_t _retries{DS3231_RETRIES};
+    uint8_t _error{DS3231_OK};            // first error since the last lastError()
+    DS3231BusStats_t _stats{};
+    uint32_t _align_latency{0};           // micros from the start of the time write to the seconds byte latched
+#ifdef DS3231_INSTRUMENTATION
+    DS3231Instrumentation _instr;
+#endif
+
+    uint8_t& _shadow_reg(uint8_t reg) { return _shadow[reg - DS3231_ALARM1]; }
+    void _load_shadow(const uint8_t *regs);
+    uint8_t _read_control(void);
+    uint8_t _read_status_config(void);
+    uint8_t _shadow_status(void);
+    void _update_control(uint8_t mask, uint8_t bits);
+    void _update_status(uint8_t mask, uint8_t bits);
+    void _write_shadow(uint8_t first, uint8_t last);
+    void _stage(uint8_t reg, const uint8_t *val, uint8_t len);
+    bool _fillable(uint8_t reg);
 
+    uint8_t _transfer(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen);
+    uint8_t _attempt(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen);
     void _write_register(uint8_t *buf, uint8_t len);
     void _write_register(uint8_t reg, uint8_t val);
     uint8_t _read_register(uint8_t reg);
     uint8_t _read_register(uint8_t reg, uint8_t *data, uint8_t len);
-    uint8_t _bin2bcd(int8_t val) { return (uint8_t) val + 6 * (val / 10); }
-    int8_t _bcd2bin(uint8_t val) { return (int8_t) (val - 6 * (val >> 4)); }
+    static bool _is_leap(int16_t yOff);
+    static uint32_t _year_start(int16_t yOff);
+    static uint16_t _month_start(int16_t yOff, int8_t m);
+    static uint32_t _days(int16_t yOff, int8_t m, int8_t d);
+    static uint32_t _seconds(uint32_t days, uint8_t hour, uint8_t minute, uint8_t second);
+    static void _from_days(uint32_t days, uint32_t secs, DateTime *dt);
+    static uint8_t _bin2bcd(int8_t val) { return (uint8_t) val + 6 * (val / 10); }
+    static int8_t _bcd2bin(uint8_t val) { return (int8_t) (val - 6 * (val >> 4)); }
+    static DateTime _decode_time(const uint8_t *buffer);
+    static void _encode_time(const DateTime &dt, uint8_t *buffer);
+    static DS3231_ALARM1_t _decode_alarm1(const uint8_t *buffer, const uint8_t *month, DateTime *dt);
+    static DS3231_ALARM2_t _decode_alarm2(const uint8_t *buffer, const uint8_t *month, DateTime *dt);
+    static void _alarm_day(const uint8_t *month, bool isDayOfWeek, uint8_t day, DateTime *dt);
+    static bool _past_2100_leap(int16_t yOff, int8_t m);
+    static void _from_chip(DateTime *dt);
+    static void _to_chip(DateTime *dt);
+    static uint8_t _chip_date(const DateTime *dt);
+    static int16_t _decode_temperature(const uint8_t *buffer);
+
+    friend class DS3231Snapshot;
+    template <typename, uint8_t, uint8_t> friend class DS3231T;
 
 };
 #endif
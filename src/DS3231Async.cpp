@@ -0,0 +1,183 @@
+#include "DS3231Async.h"
+
+#define PHASE_IDLE    0
+#define PHASE_ADDRESS 1
+#define PHASE_READ    2
+
+
+/**************************************************************************/
+/*!
+  @brief  Start a transaction
+  @param  wbuf bytes to be written, register address first
+  @param  wlen number of bytes to be written
+  @param  rbuf buffer for the bytes read after a repeated START
+  @param  rlen number of bytes to be read, 0 for a write-only transaction
+  @return True if the transaction is started
+*/
+/**************************************************************************/
+bool DS3231WireTransport::start(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen) {
+  if (_phase != PHASE_IDLE)
+    return false;
+  _wbuf = wbuf;
+  _wlen = wlen;
+  _rbuf = rbuf;
+  _rlen = rlen;
+  _phase = PHASE_ADDRESS;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Run the next phase of the transaction
+  @return DS3231_ASYNC_BUSY, 0 when done, the endTransmission() error or
+  DS3231_ERR_READ for a short read
+*/
+/**************************************************************************/
+int8_t DS3231WireTransport::poll(void) {
+  if (_phase == PHASE_ADDRESS) {
+    _wire->beginTransmission(DS3231_ADDRESS);
+    _wire->write(_wbuf, _wlen);
+    uint8_t err = _wire->endTransmission(_rlen == 0);
+    if (err || _rlen == 0) {
+      _phase = PHASE_IDLE;
+      return err;
+    }
+    _phase = PHASE_READ;
+    return DS3231_ASYNC_BUSY;
+  }
+
+  if (_phase == PHASE_READ) {
+    _phase = PHASE_IDLE;
+    uint8_t i = 0;
+    _wire->requestFrom(DS3231_ADDRESS, _rlen);
+    while (_wire->available() && i < _rlen)
+      _rbuf[i++] = _wire->read();
+    return (i == _rlen) ? 0 : DS3231_ERR_READ;
+  }
+
+  return 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Queue a read
+  @param  op DS3231_ASYNC_NOW, DS3231_ASYNC_TEMPERATURE or DS3231_ASYNC_SNAPSHOT
+  @param  callback function called on completion with the registers read
+  @return True if queued, false if the queue is full
+  @details Reads that are queued back to back and cover close registers are
+  served by a single burst.
+*/
+/**************************************************************************/
+bool DS3231Async::startRead(DS3231_ASYNC_OP_t op, DS3231AsyncCallback_t callback) {
+  if (op == DS3231_ASYNC_WRITE)
+    return false;
+  return _push({op, callback, nullptr, 0});
+}
+
+/**************************************************************************/
+/*!
+  @brief  Queue a write
+  @param  buf register address followed by the values, it has to remain
+  valid until the callback is called
+  @param  len length of buf
+  @param  callback function called on completion, can be nullptr
+  @return True if queued, false if the queue is full
+*/
+/**************************************************************************/
+bool DS3231Async::startWrite(const uint8_t *buf, uint8_t len, DS3231AsyncCallback_t callback) {
+  return _push({DS3231_ASYNC_WRITE, callback, buf, len});
+}
+
+/**************************************************************************/
+/*!
+  @brief  Advance the queued operations, never waits on the bus
+  @return True when there is nothing left to do
+  @details Call it from loop(). The callbacks are called from here.
+*/
+/**************************************************************************/
+bool DS3231Async::poll(void) {
+  if (_batch) {
+    int8_t result = _transport->poll();
+    if (result == DS3231_ASYNC_BUSY)
+      return false;
+    _complete(static_cast<uint8_t>(result));
+  }
+
+  if (_count == 0)
+    return true;
+  _start();
+  return false;
+}
+
+bool DS3231Async::_push(const Request_t &req) {
+  if (_count == DS3231_ASYNC_QUEUE_SIZE)
+    return false;
+  _queue[(_head + _count) % DS3231_ASYNC_QUEUE_SIZE] = req;
+  _count++;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Start the transaction for the request at the head of the queue,
+  merged with the reads queued after it when their registers are close
+  @details When the transport does not start it, the requests fail with
+  DS3231_ERR_OTHER.
+*/
+/**************************************************************************/
+void DS3231Async::_start(void) {
+  const Request_t &head = _queue[_head];
+  if (head.op == DS3231_ASYNC_WRITE) {
+    _batch = 1;
+    if (!_transport->start(head.buf, head.len, nullptr, 0))
+      _complete(DS3231_ERR_OTHER);
+    return;
+  }
+
+  uint8_t first, last;
+  _range(head.op, &first, &last);
+  _batch = 1;
+  while (_batch < _count) {
+    const Request_t &next = _queue[(_head + _batch) % DS3231_ASYNC_QUEUE_SIZE];
+    if (next.op == DS3231_ASYNC_WRITE)
+      break;  // keep the order of reads and writes
+    uint8_t f, l;
+    _range(next.op, &f, &l);
+    if (f > last + DS3231_ASYNC_MERGE_GAP || l + DS3231_ASYNC_MERGE_GAP < first)
+      break;
+    if (f < first) first = f;
+    if (l > last) last = l;
+    _batch++;
+  }
+
+  _address = first;
+  if (!_transport->start(&_address, 1, &_snap.reg[first], last - first + 1))
+    _complete(DS3231_ERR_OTHER);
+}
+
+void DS3231Async::_complete(uint8_t error) {
+  while (_batch) {
+    Request_t req = _queue[_head];
+    _head = (_head + 1) % DS3231_ASYNC_QUEUE_SIZE;
+    _count--;
+    _batch--;
+    if (req.callback)
+      req.callback(req.op, &_snap, error);
+  }
+}
+
+void DS3231Async::_range(DS3231_ASYNC_OP_t op, uint8_t *first, uint8_t *last) {
+  switch (op) {
+    case DS3231_ASYNC_NOW:
+      *first = DS3231_TIME;
+      *last = DS3231_TIME + 6;
+      break;
+    case DS3231_ASYNC_TEMPERATURE:
+      *first = DS3231_TEMPERATURE;
+      *last = DS3231_TEMPERATURE + 1;
+      break;
+    default:
+      *first = DS3231_TIME;
+      *last = DS3231_REGISTERS - 1;
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef __DS3231_ASYNC_H__
+#define __DS3231_ASYNC_H__
+#include "DS3231.h"
+
+#define DS3231_ASYNC_QUEUE_SIZE 4   // pending operations
+#define DS3231_ASYNC_MERGE_GAP  3   // reads closer than this are merged into one burst
+#define DS3231_ASYNC_BUSY       -1
+
+typedef enum {
+  DS3231_ASYNC_NOW,          // time registers 0x00 - 0x06
+  DS3231_ASYNC_TEMPERATURE,  // temperature registers 0x11 - 0x12
+  DS3231_ASYNC_SNAPSHOT,     // all registers 0x00 - 0x12
+  DS3231_ASYNC_WRITE         // caller provided buffer, register address first
+} DS3231_ASYNC_OP_t;
+
+// Called on completion, the registers read by the operation are in snap,
+// error is 0 on success, the error code of the transport or DS3231_ERR_OTHER
+// when the transport did not start the transaction
+typedef void (*DS3231AsyncCallback_t)(DS3231_ASYNC_OP_t op, const DS3231Snapshot *snap, uint8_t error);
+
+// One I2C transaction that completes in the background, implement it for an
+// interrupt or DMA driven TWI peripheral
+class DS3231Transport
+{
+public:
+  virtual ~DS3231Transport() {}
+  virtual bool start(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen) = 0;
+  virtual int8_t poll(void) = 0;  // DS3231_ASYNC_BUSY, 0 when done or an error code
+};
+
+// Cooperative transport on Wire, each poll() runs one phase of the transaction.
+// A read ends its first poll() with the register address sent and no STOP
+// (endTransmission(false)), the repeated START stays pending until the
+// poll() that reads the data: no other device can use the bus in between.
+class DS3231WireTransport : public DS3231Transport
+{
+public:
+  DS3231WireTransport(TwoWire *wire) : _wire(wire) {}
+  bool start(const uint8_t *wbuf, uint8_t wlen, uint8_t *rbuf, uint8_t rlen) override;
+  int8_t poll(void) override;
+
+private:
+  TwoWire *_wire;
+  const uint8_t *_wbuf{nullptr};
+  uint8_t *_rbuf{nullptr};
+  uint8_t _wlen{0};
+  uint8_t _rlen{0};
+  uint8_t _phase{0};
+};
+
+class DS3231Async
+{
+public:
+  void begin(DS3231Transport *transport) { _transport = transport; }
+  bool startRead(DS3231_ASYNC_OP_t op, DS3231AsyncCallback_t callback);
+  bool startWrite(const uint8_t *buf, uint8_t len, DS3231AsyncCallback_t callback);
+  bool poll(void);
+  uint8_t pending(void) const { return _count; }
+
+private:
+  typedef struct {
+    DS3231_ASYNC_OP_t op;
+    DS3231AsyncCallback_t callback;
+    const uint8_t *buf;
+    uint8_t len;
+  } Request_t;
+
+  DS3231Transport *_transport{nullptr};
+  Request_t _queue[DS3231_ASYNC_QUEUE_SIZE];
+  uint8_t _head{0};
+  uint8_t _count{0};
+  uint8_t _batch{0};      // requests served by the transaction in progress
+  uint8_t _address{0};    // register pointer of the read in progress
+  DS3231Snapshot _snap{};
+
+  bool _push(const Request_t &req);
+  void _start(void);
+  void _complete(uint8_t error);
+  static void _range(DS3231_ASYNC_OP_t op, uint8_t *first, uint8_t *last);
+};
+#endif
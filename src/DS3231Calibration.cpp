@@ -0,0 +1,229 @@
+#include "DS3231Calibration.h"
+
+
+/**************************************************************************/
+/*!
+  @brief  Start the calibration
+  @param  rtc pointer to a DS3231 object that has been begin()
+  @param  reference source of the true time
+  @param  state state saved from a previous calibration, nullptr to start
+  from scratch
+  @details When the aging offset of the RTC has been changed since the
+  state was saved, the previous measurements are corrected for it.
+*/
+/**************************************************************************/
+void DS3231Calibration::begin(DS3231 *rtc, DS3231Reference *reference, const DS3231Calibration_t *state) {
+  _rtc = rtc;
+  _reference = reference;
+  if (!state) {
+    reset();
+    return;
+  }
+  _state = *state;
+  int8_t aging = _rtc->getAgingOffset();
+  if (aging != _state.aging) {
+    _shift(aging - _state.aging);
+    _state.epoch = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  Discard all the measurements
+*/
+/**************************************************************************/
+void DS3231Calibration::reset(void) {
+  _state = DS3231Calibration_t{};
+  _state.aging = _rtc->getAgingOffset();
+}
+
+/**************************************************************************/
+/*!
+  @brief  Measure the offset of the RTC against the reference
+  @return True if the sample is taken
+  @details Finds the second boundary of the RTC by reading the time every
+  DS3231_CALIBRATION_POLL_MS, waits until just before the next one and only
+  then reads the time back to back, so the bus is busy for about
+  DS3231_CALIBRATION_POLL_MS instead of a whole second. The reference is
+  read right after the boundary. Takes up to 2 seconds. The interval since
+  the previous sample is added to the fit, unless its error is larger than
+  DS3231_CALIBRATION_MAX_PPM, e.g. when the time has been adjusted.
+*/
+/**************************************************************************/
+bool DS3231Calibration::sample(void) {
+  uint32_t start = _rtc->epochNow();
+  uint32_t epoch = start;
+  uint32_t started = millis();
+  uint32_t polled = started;
+  while (epoch == start) {
+    if (millis() - started > 1100)
+      return false;  // the oscillator is stopped
+    polled = millis();
+    delay(DS3231_CALIBRATION_POLL_MS);
+    epoch = _rtc->epochNow();
+  }
+
+  // the boundary was between polled and now, the next one a second later
+  start = epoch;
+  while (millis() - polled < 1000 - DS3231_CALIBRATION_MARGIN_MS)
+    delay(1);
+  started = millis();
+  while (epoch == start) {
+    if (millis() - started > 2 * DS3231_CALIBRATION_POLL_MS)
+      return false;
+    epoch = _rtc->epochNow();
+  }
+
+  uint32_t ref_epoch, ref_usec;
+  if (!_reference->read(&ref_epoch, &ref_usec))
+    return false;
+  int16_t temperature = _rtc->getTemperatureRaw();
+
+  int64_t diff = ((int64_t) epoch - ref_epoch) * 1000000L - ref_usec;
+  if (diff > INT32_MAX || diff < INT32_MIN) {
+    _state.epoch = 0;  // the RTC is not set
+    return false;
+  }
+  int32_t offset = static_cast<int32_t>(diff);
+
+  if (_state.epoch && ref_epoch > _state.epoch) {
+    uint32_t seconds = ref_epoch - _state.epoch;
+    float ppm = static_cast<float>(offset - _state.offset) / seconds;  // microseconds per second
+    if (ppm <= DS3231_CALIBRATION_MAX_PPM && ppm >= -DS3231_CALIBRATION_MAX_PPM) {
+      float w = seconds / 3600.0f;
+      float t = (temperature + _state.temperature) / 8.0f;  // mean of the two samples in degree Celsius
+      _state.w += w;
+      _state.wt += w * t;
+      _state.wtt += w * t * t;
+      _state.wp += w * ppm;
+      _state.wpt += w * ppm * t;
+      _state.intervals++;
+    }
+  }
+
+  _state.epoch = ref_epoch;
+  _state.offset = offset;
+  _state.temperature = temperature;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Estimated frequency error at the mean temperature of the samples
+  @return ppm, positive when the RTC runs fast
+*/
+/**************************************************************************/
+float DS3231Calibration::ppm(void) const {
+  return (_state.w > 0) ? _state.wp / _state.w : 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Estimated frequency error at a temperature
+  @param  celsius temperature in degree Celsius
+  @return ppm, positive when the RTC runs fast
+  @details Least squares fit of the error as a linear function of the
+  temperature. Same as ppm() until the samples spread over about one degree.
+*/
+/**************************************************************************/
+float DS3231Calibration::ppm(float celsius) const {
+  float d = _state.w * _state.wtt - _state.wt * _state.wt;  // w^2 times the variance of the temperature
+  if (d <= 0.25f * _state.w * _state.w)
+    return ppm();
+  float slope = (_state.w * _state.wpt - _state.wt * _state.wp) / d;
+  return (_state.wp - slope * _state.wt) / _state.w + slope * celsius;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Aging offset that cancels the error at the mean temperature
+  @return aging offset
+*/
+/**************************************************************************/
+int8_t DS3231Calibration::recommended(void) const {
+  return _aging(ppm());
+}
+
+/**************************************************************************/
+/*!
+  @brief  Aging offset that cancels the error at a temperature
+  @param  celsius temperature in degree Celsius, e.g. the usual temperature
+  of the RTC when it differs from the mean of the samples
+  @return aging offset
+  @details Uses the fit of ppm(celsius), same as recommended() until the
+  samples spread over about one degree.
+*/
+/**************************************************************************/
+int8_t DS3231Calibration::recommended(float celsius) const {
+  return _aging(ppm(celsius));
+}
+
+/**************************************************************************/
+/*!
+  @brief  Write the recommended() aging offset to the RTC
+  @return True if the aging offset is verified
+  @details The measurements are kept, corrected for the new offset, so that
+  the next samples refine the estimation. Save state() afterwards.
+*/
+/**************************************************************************/
+bool DS3231Calibration::apply(void) {
+  return _apply(recommended());
+}
+
+/**************************************************************************/
+/*!
+  @brief  Write the recommended(celsius) aging offset to the RTC
+  @param  celsius temperature in degree Celsius the error is cancelled at
+  @return True if the aging offset is verified
+*/
+/**************************************************************************/
+bool DS3231Calibration::apply(float celsius) {
+  return _apply(recommended(celsius));
+}
+
+/**************************************************************************/
+/*!
+  @brief  Aging offset that cancels an error
+  @param  ppm error with the current aging offset
+  @return aging offset
+*/
+/**************************************************************************/
+int8_t DS3231Calibration::_aging(float ppm) const {
+  float lsb = ppm / DS3231_CALIBRATION_PPM_LSB;
+  int32_t aging = _state.aging + static_cast<int32_t>(lsb + ((lsb < 0) ? -0.5f : 0.5f));
+  if (aging > 127)
+    aging = 127;
+  if (aging < -128)
+    aging = -128;
+  return static_cast<int8_t>(aging);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Write an aging offset to the RTC and correct the measurements
+  @param  aging aging offset
+  @return True if the aging offset is verified
+*/
+/**************************************************************************/
+bool DS3231Calibration::_apply(int8_t aging) {
+  if (aging == _state.aging)
+    return true;
+  if (!_rtc->setAgingOffset(aging))
+    return false;
+  _shift(aging - _state.aging);
+  _state.epoch = 0;  // an interval across the change would mix both offsets
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Correct the measurements for a change of the aging offset
+  @param  delta new minus old aging offset
+*/
+/**************************************************************************/
+void DS3231Calibration::_shift(int16_t delta) {
+  float p = delta * DS3231_CALIBRATION_PPM_LSB;
+  _state.wp -= p * _state.w;
+  _state.wpt -= p * _state.wt;
+  _state.aging += delta;
+}
@@ -0,0 +1,63 @@
+#ifndef __DS3231_CALIBRATION_H__
+#define __DS3231_CALIBRATION_H__
+#include "DS3231.h"
+
+#define DS3231_CALIBRATION_MAX_PPM  100   // intervals with a larger error are discarded (time adjusted)
+#define DS3231_CALIBRATION_PPM_LSB  0.1f  // aging offset per ppm at 25 degree Celsius
+#define DS3231_CALIBRATION_POLL_MS  20    // period of the reads looking for the second boundary
+#define DS3231_CALIBRATION_MARGIN_MS 2    // reads back to back from this long before the boundary
+
+// Source of the true time, e.g. timestamps from a host over the serial port,
+// a GPS or NTP. read() returns the time at the moment it is called, a
+// constant delay of the source does not affect the calibration.
+class DS3231Reference
+{
+public:
+  virtual bool read(uint32_t *epoch, uint32_t *usec) = 0;  // seconds since 2000/01/01 00:00:00
+};
+
+// State of the calibration, save it (e.g. in EEPROM) and pass it to begin()
+// so that the next calibration continues from where it has stopped. The
+// least squares sums are weighted by the length of each interval in hours.
+typedef struct {
+  int8_t aging;          // aging offset of the RTC the sums are relative to
+  uint16_t intervals;    // number of intervals measured
+  uint32_t epoch;        // reference time of the last sample, 0 for none
+  int32_t offset;        // RTC - reference in microseconds at the last sample
+  int16_t temperature;   // temperature at the last sample, quarter degrees
+  float w, wt, wtt;      // sum of weights, weighted temperatures and their squares
+  float wp, wpt;         // weighted ppm errors, and ppm error times temperature
+} DS3231Calibration_t;
+
+// Measures the frequency error of the RTC against a reference and corrects
+// it with the aging offset. The error is fitted as a linear function of the
+// temperature over all the intervals between samples, take the samples
+// hours apart and at the temperatures the RTC is used at. recommended() and
+// apply() cancel the error at the mean temperature of the samples, pass the
+// temperature the RTC usually runs at to use the fit instead.
+class DS3231Calibration
+{
+public:
+  void begin(DS3231 *rtc, DS3231Reference *reference, const DS3231Calibration_t *state = nullptr);
+  void reset(void);
+  bool sample(void);
+  int32_t offset(void) const { return _state.offset; }
+  uint16_t intervals(void) const { return _state.intervals; }
+  float ppm(void) const;
+  float ppm(float celsius) const;
+  int8_t recommended(void) const;
+  int8_t recommended(float celsius) const;
+  bool apply(void);
+  bool apply(float celsius);
+  const DS3231Calibration_t& state(void) const { return _state; }
+
+private:
+  DS3231 *_rtc{nullptr};
+  DS3231Reference *_reference{nullptr};
+  DS3231Calibration_t _state{};
+
+  int8_t _aging(float ppm) const;
+  bool _apply(int8_t aging);
+  void _shift(int16_t delta);
+};
+#endif
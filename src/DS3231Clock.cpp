@@ -0,0 +1,157 @@
+#include "DS3231Clock.h"
+
+
+/**************************************************************************/
+/*!
+  @brief  Start the disciplined clock
+  @param  rtc pointer to a DS3231 object that has been begin()
+  @return True
+  @details Set the SQW output to 1Hz, the INT/SQW pin needs to be connected
+  to an interrupt pin that calls tick() on each falling edge. The clock is
+  synchronised with the RTC by update() after the first edge.
+*/
+/**************************************************************************/
+bool DS3231Clock::begin(DS3231 *rtc) {
+  _rtc = rtc;
+  _synced = false;
+  _rtc->setSquareWaveRate(DS3231_SQW_1HZ);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Count a second, to be called from the SQW falling edge ISR
+  @details The DS3231 seconds register increments on the falling edge of
+  the 1Hz square wave.
+*/
+/**************************************************************************/
+void DS3231Clock::tick(void) {
+  uint32_t now = micros();
+  _period = now - _edge_micros;
+  _edge_micros = now;
+  _edges++;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Synchronise with the RTC if it is not done yet
+  @return True if the clock is synchronised
+  @details Call it from loop(), it only accesses the I2C bus until the
+  clock is synchronised.
+*/
+/**************************************************************************/
+bool DS3231Clock::update(void) {
+  if (!_synced)
+    _sync();
+  return _synced;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the current time without accessing the I2C bus
+  @param  usec optional pointer for the microseconds elapsed in the second
+  @return seconds since 2000/01/01 00:00:00, see DS3231::toEpoch(), 0 (and
+  0 microseconds) until the clock has been synchronised by update()
+*/
+/**************************************************************************/
+uint32_t DS3231Clock::nowFast(uint32_t *usec) {
+  if (!_synced) {
+    if (usec)
+      *usec = 0;
+    return 0;
+  }
+  uint32_t edges, edge_micros;
+  _edge_state(&edges, &edge_micros);
+
+  if (usec) {
+    uint32_t elapsed = micros() - edge_micros;
+    *usec = (elapsed > 999999UL) ? 999999UL : elapsed;  // a missed edge never runs into the next second
+  }
+  return _base_epoch + (edges - _base_edges);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Check the software clock against the RTC
+  @return difference in seconds (RTC - software clock), 0 if consistent
+  or not synchronised yet
+  @details The software clock is re-synchronised when there is a difference,
+  e.g. an edge was missed because the interrupt was disabled for too long.
+  Before the first synchronisation it only tries to synchronise, as
+  update() does.
+*/
+/**************************************************************************/
+int32_t DS3231Clock::verify(void) {
+  if (!_synced) {
+    _sync();
+    return 0;
+  }
+  uint32_t edges, edge_micros;
+  _edge_state(&edges, &edge_micros);
+  uint32_t fast = _base_epoch + (edges - _base_edges);
+
+  uint32_t epoch = _rtc->epochNow();
+  uint32_t after;
+  _edge_state(&after, &edge_micros);
+  if (after != edges)  // the second rolled over during the read, try later
+    return 0;
+
+  int32_t drift = static_cast<int32_t>(epoch - fast);
+  if (drift != 0) {
+    _base_epoch = epoch;
+    _base_edges = edges;
+  }
+  return drift;
+}
+
+/**************************************************************************/
+/*!
+  @brief  MCU clock error measured against the SQW 1Hz output
+  @return error of micros() in ppm, positive when the MCU clock runs fast,
+  0 before two edges have been seen
+*/
+/**************************************************************************/
+int32_t DS3231Clock::ppm(void) {
+  noInterrupts();
+  uint32_t period = _period;
+  bool valid = _edges > 1;
+  interrupts();
+  return valid ? static_cast<int32_t>(period - 1000000UL) : 0;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Latch the RTC time against the edge count
+  @return True if synchronised
+*/
+/**************************************************************************/
+bool DS3231Clock::_sync(void) {
+  uint32_t edges, after, edge_micros;
+  _edge_state(&edges, &edge_micros);
+  if (edges == 0)  // wait for the first edge so the second count is aligned
+    return false;
+
+  uint32_t epoch = _rtc->epochNow();
+  _edge_state(&after, &edge_micros);
+  if (after != edges)  // the second rolled over during the read
+    return false;
+
+  _base_epoch = epoch;
+  _base_edges = edges;
+  _synced = true;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Read the state updated by tick() atomically
+  @param  edges pointer for the edge count
+  @param  edge_micros pointer for micros() at the last edge
+*/
+/**************************************************************************/
+void DS3231Clock::_edge_state(uint32_t *edges, uint32_t *edge_micros) {
+  noInterrupts();
+  *edges = _edges;
+  *edge_micros = _edge_micros;
+  interrupts();
+}
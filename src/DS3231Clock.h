@@ -0,0 +1,32 @@
+#ifndef __DS3231_CLOCK_H__
+#define __DS3231_CLOCK_H__
+#include "DS3231.h"
+
+// Software clock disciplined by the DS3231 1Hz SQW output. The second count
+// is kept by tick() called from the SQW falling edge interrupt and the time
+// within the second is interpolated with micros(), so nowFast() never
+// accesses the I2C bus.
+class DS3231Clock
+{
+public:
+  bool begin(DS3231 *rtc);
+  void tick(void);
+  bool update(void);
+  bool isSynced(void) const { return _synced; }
+  uint32_t nowFast(uint32_t *usec = nullptr);
+  int32_t verify(void);
+  int32_t ppm(void);
+
+private:
+  DS3231 *_rtc{nullptr};
+  volatile uint32_t _edges{0};        // number of SQW edges since begin()
+  volatile uint32_t _edge_micros{0};  // micros() at the last edge
+  volatile uint32_t _period{0};       // micros() between the last two edges
+  uint32_t _base_epoch{0};            // RTC time at _base_edges
+  uint32_t _base_edges{0};
+  bool _synced{false};
+
+  bool _sync(void);
+  void _edge_state(uint32_t *edges, uint32_t *edge_micros);
+};
+#endif
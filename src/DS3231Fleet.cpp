@@ -0,0 +1,225 @@
+#include "DS3231Fleet.h"
+
+
+DS3231FleetBase::DS3231FleetBase(DS3231Device_t *devices, DS3231Reading_t *readings, uint16_t *order, uint16_t capacity)
+  : _devices(devices), _readings(readings), _order(order), _capacity(capacity) {
+}
+
+/**************************************************************************/
+/*!
+  @brief  Start the fleet without any device
+  @param  first first register to be polled
+  @param  count number of registers to be polled, e.g. 7 for the time only
+  @details The buses have to be begin() by the caller.
+*/
+/**************************************************************************/
+void DS3231FleetBase::begin(uint8_t first, uint8_t count) {
+  if (first >= DS3231_REGISTERS)
+    first = DS3231_TIME;
+  if (count == 0 || first + count > DS3231_REGISTERS)
+    count = DS3231_REGISTERS - first;
+  _first = first;
+  _len = count;
+  _count = 0;
+  _cursor = 0;
+  _sweeps = 0;
+  _switches = 0;
+  for (uint8_t i = 0; i < DS3231_FLEET_BUSES; i++)
+    _selected[i] = {nullptr, DS3231_FLEET_NO_MUX, 0, 0};
+}
+
+/**************************************************************************/
+/*!
+  @brief  Register a device
+  @param  wire bus of the device
+  @param  mux address of the multiplexer, DS3231_FLEET_NO_MUX if the device
+  is directly on the bus
+  @param  channel channel of the multiplexer (0 - 7)
+  @param  address I2C address of the device
+  @return device id, the index of its reading in readings(), or -1 if the
+  fleet is full or already has DS3231_FLEET_BUSES other buses
+*/
+/**************************************************************************/
+int16_t DS3231FleetBase::add(TwoWire *wire, uint8_t mux, uint8_t channel, uint8_t address) {
+  if (_count == _capacity)
+    return -1;
+  if (_bus(wire) == DS3231_FLEET_BUSES) {
+    uint8_t i = 0;
+    while (i < DS3231_FLEET_BUSES && _selected[i].wire)
+      i++;
+    if (i == DS3231_FLEET_BUSES)
+      return -1;
+    _selected[i] = {wire, DS3231_FLEET_NO_MUX, 0, 0};
+  }
+
+  uint16_t id = _count++;
+  _devices[id] = {wire, mux, static_cast<uint8_t>(channel & 0x07), address};
+  _readings[id] = DS3231Reading_t{};
+
+  // keep the polling order sorted, after the devices on the same channel
+  uint16_t pos = id;
+  while (pos > 0 && _compare(_devices[_order[pos - 1]], _devices[id]) > 0) {
+    _order[pos] = _order[pos - 1];
+    pos--;
+  }
+  _order[pos] = id;
+  if (pos < _cursor)
+    _cursor++;
+  return id;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Poll the next devices within the budget
+  @return number of devices read
+  @details Each read costs one I2C transaction, selecting a channel one or
+  two more. At least one device is read per call even if its cost exceeds
+  the budget. A device that failed DS3231_FLEET_RETRY times in a row is
+  only tried once every DS3231_FLEET_RETRY sweeps.
+*/
+/**************************************************************************/
+uint16_t DS3231FleetBase::poll(void) {
+  uint16_t budget = _budget;
+  uint16_t polled = 0;
+
+  for (uint16_t n = 0; n < _count && budget; n++) {
+    uint16_t id = _order[_cursor];
+    if (!_skip(_readings[id])) {
+      uint16_t cost = 1 + _select_cost(_devices[id]);
+      if (cost > budget && polled)
+        break;  // next call starts with this device
+      budget = (cost < budget) ? budget - cost : 0;
+      _read(id);
+      polled++;
+    }
+    if (++_cursor == _count) {
+      _cursor = 0;
+      _sweeps++;
+    }
+  }
+  return polled;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Number of devices whose last read failed
+  @return number of devices
+*/
+/**************************************************************************/
+uint16_t DS3231FleetBase::failed(void) const {
+  uint16_t n = 0;
+  for (uint16_t id = 0; id < _count; id++) {
+    if (_readings[id].error)
+      n++;
+  }
+  return n;
+}
+
+int8_t DS3231FleetBase::_compare(const DS3231Device_t &a, const DS3231Device_t &b) {
+  if (a.wire != b.wire)
+    return (reinterpret_cast<uintptr_t>(a.wire) < reinterpret_cast<uintptr_t>(b.wire)) ? -1 : 1;
+  if (a.mux != b.mux)
+    return (a.mux < b.mux) ? -1 : 1;
+  if (a.channel != b.channel)
+    return (a.channel < b.channel) ? -1 : 1;
+  if (a.address != b.address)
+    return (a.address < b.address) ? -1 : 1;
+  return 0;
+}
+
+bool DS3231FleetBase::_skip(const DS3231Reading_t &r) const {
+  return r.failures >= DS3231_FLEET_RETRY && (_sweeps % DS3231_FLEET_RETRY) != 0;
+}
+
+// Index of a bus in _selected, DS3231_FLEET_BUSES for an unknown bus
+uint8_t DS3231FleetBase::_bus(const TwoWire *wire) const {
+  uint8_t i = 0;
+  while (i < DS3231_FLEET_BUSES && _selected[i].wire != wire)
+    i++;
+  return i;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Transactions needed to make a device reachable
+  @details The channel enabled on another multiplexer of the same bus is
+  disabled first, a DS3231 behind it would answer on the same address. The
+  channels enabled on the other buses are left as they are.
+*/
+/**************************************************************************/
+uint8_t DS3231FleetBase::_select_cost(const DS3231Device_t &dev) const {
+  const DS3231Device_t &sel = _selected[_bus(dev.wire)];
+  if (sel.mux == dev.mux && (dev.mux == DS3231_FLEET_NO_MUX || sel.channel == dev.channel))
+    return 0;
+  uint8_t cost = (dev.mux != DS3231_FLEET_NO_MUX) ? 1 : 0;
+  if (sel.mux != DS3231_FLEET_NO_MUX && sel.mux != dev.mux)
+    cost++;
+  return cost;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Enable the multiplexer channel of a device
+  @return 0, or DS3231_FLEET_MUX_ERROR | the endTransmission() error
+  @details After an error the channel is unknown, the next device of the
+  multiplexer selects it again.
+*/
+/**************************************************************************/
+uint8_t DS3231FleetBase::_select(const DS3231Device_t &dev) {
+  if (_select_cost(dev) == 0)
+    return 0;
+
+  DS3231Device_t &sel = _selected[_bus(dev.wire)];
+  if (sel.mux != DS3231_FLEET_NO_MUX && sel.mux != dev.mux) {
+    dev.wire->beginTransmission(sel.mux);
+    dev.wire->write(static_cast<uint8_t>(0));
+    uint8_t err = dev.wire->endTransmission();
+    if (err) {
+      sel.channel = DS3231_FLEET_UNKNOWN;
+      return DS3231_FLEET_MUX_ERROR | err;
+    }
+    sel.mux = DS3231_FLEET_NO_MUX;
+  }
+
+  if (dev.mux != DS3231_FLEET_NO_MUX) {
+    sel.mux = dev.mux;
+    sel.channel = DS3231_FLEET_UNKNOWN;
+    dev.wire->beginTransmission(dev.mux);
+    dev.wire->write(static_cast<uint8_t>(1 << dev.channel));
+    uint8_t err = dev.wire->endTransmission();
+    if (err)
+      return DS3231_FLEET_MUX_ERROR | err;
+    sel.channel = dev.channel;
+    _switches++;
+  }
+  return 0;
+}
+
+void DS3231FleetBase::_read(uint16_t id) {
+  const DS3231Device_t &dev = _devices[id];
+  DS3231Reading_t &r = _readings[id];
+  uint32_t start = micros();
+
+  uint8_t error = _select(dev);
+  if (!error) {
+    dev.wire->beginTransmission(dev.address);
+    dev.wire->write(_first);
+    error = dev.wire->endTransmission(false);
+  }
+  if (!error) {
+    uint8_t i = 0;
+    dev.wire->requestFrom(dev.address, _len);
+    while (dev.wire->available() && i < _len)
+      r.snap.reg[_first + i++] = dev.wire->read();
+    error = (i == _len) ? 0 : DS3231_ERR_READ;
+  }
+
+  uint32_t duration = micros() - start;
+  r.time = start;
+  r.duration = (duration > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(duration);
+  r.error = error;
+  if (!error)
+    r.failures = 0;
+  else if (r.failures < 0xFF)
+    r.failures++;
+}
@@ -0,0 +1,86 @@
+#ifndef __DS3231_FLEET_H__
+#define __DS3231_FLEET_H__
+#include "DS3231.h"
+
+#define DS3231_FLEET_NO_MUX     0     // device directly on the bus
+#define DS3231_FLEET_MUX_ERROR  0x80  // or-ed with the endTransmission() error of the mux
+#define DS3231_FLEET_RETRY      8     // failures in a row before a device is only tried every 8 sweeps
+#ifndef DS3231_FLEET_BUSES
+#define DS3231_FLEET_BUSES      4     // buses of a fleet, each one keeps its own multiplexer channel enabled
+#endif
+#define DS3231_FLEET_UNKNOWN    0xFF  // channel of a multiplexer whose state is unknown after an error
+
+// Where a DS3231 is: the bus, the I2C multiplexer (TCA9548A or compatible)
+// and its channel, and the address of the DS3231
+typedef struct {
+  TwoWire *wire;
+  uint8_t mux;       // address of the multiplexer, DS3231_FLEET_NO_MUX for none
+  uint8_t channel;   // 0 - 7
+  uint8_t address;
+} DS3231Device_t;
+
+// Result of the last read of a device
+typedef struct {
+  DS3231Snapshot snap;  // only the registers polled are updated
+  uint32_t time;        // micros() at the start of the read
+  uint16_t duration;    // micros spent on the read, including the selection of the channel
+  uint8_t error;        // 0, the Wire error code, DS3231_ERR_READ or DS3231_FLEET_MUX_ERROR | mux error
+  uint8_t failures;     // reads failed in a row
+} DS3231Reading_t;
+
+// Polls many DS3231 across buses and multiplexers, a few devices per call
+// of poll() within a budget of I2C transactions. The devices are polled
+// in the order of their bus, multiplexer and channel so a channel is only
+// selected once per sweep. Use DS3231Fleet<N> for N devices.
+class DS3231FleetBase
+{
+public:
+  void begin(uint8_t first = DS3231_TIME, uint8_t count = DS3231_REGISTERS);
+  int16_t add(TwoWire *wire, uint8_t mux, uint8_t channel, uint8_t address = DS3231_ADDRESS);
+  void setBudget(uint16_t transactions) { _budget = transactions ? transactions : 1; }
+  uint16_t poll(void);
+  uint16_t count(void) const { return _count; }
+  uint16_t failed(void) const;
+  uint32_t sweeps(void) const { return _sweeps; }
+  uint32_t switches(void) const { return _switches; }
+  const DS3231Device_t& device(uint16_t id) const { return _devices[id]; }
+  const DS3231Reading_t& reading(uint16_t id) const { return _readings[id]; }
+  const DS3231Reading_t* readings(void) const { return _readings; }
+
+protected:
+  DS3231FleetBase(DS3231Device_t *devices, DS3231Reading_t *readings, uint16_t *order, uint16_t capacity);
+
+private:
+  DS3231Device_t *_devices;
+  DS3231Reading_t *_readings;
+  uint16_t *_order;        // device ids sorted by bus, multiplexer and channel
+  uint16_t _capacity;
+  uint16_t _count{0};
+  uint16_t _cursor{0};     // position in _order of the next device to be polled
+  uint16_t _budget{8};     // I2C transactions per poll()
+  uint8_t _first{DS3231_TIME};
+  uint8_t _len{DS3231_REGISTERS};
+  uint32_t _sweeps{0};
+  uint32_t _switches{0};
+  DS3231Device_t _selected[DS3231_FLEET_BUSES]{};  // multiplexer channel enabled on each bus, wire nullptr when unused
+
+  static int8_t _compare(const DS3231Device_t &a, const DS3231Device_t &b);
+  bool _skip(const DS3231Reading_t &r) const;
+  uint8_t _bus(const TwoWire *wire) const;
+  uint8_t _select_cost(const DS3231Device_t &dev) const;
+  uint8_t _select(const DS3231Device_t &dev);
+  void _read(uint16_t id);
+};
+
+template <uint16_t N>
+class DS3231Fleet : public DS3231FleetBase
+{
+public:
+  DS3231Fleet() : DS3231FleetBase(_fleet, _results, _order, N) {}
+
+private:
+  DS3231Device_t _fleet[N];
+  DS3231Reading_t _results[N];
+  uint16_t _order[N];
+};
+#endif
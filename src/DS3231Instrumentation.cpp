@@ -0,0 +1,180 @@
+#ifdef DS3231_INSTRUMENTATION
+#include "DS3231Instrumentation.h"
+
+/**************************************************************************/
+/*!
+  @brief  Start counting a call of a public method
+  @param  method DS3231_METHOD_t
+  @return False when called from another method, which counts the call
+*/
+/**************************************************************************/
+bool DS3231Instrumentation::enter(uint8_t method) {
+  if (_method != DS3231_METHOD_OTHER)
+    return false;
+  _method = method;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Count the call started by enter()
+  @param  latency micros spent in the method
+*/
+/**************************************************************************/
+void DS3231Instrumentation::leave(uint32_t latency) {
+  DS3231MethodStats_t &m = _methods[_method];
+  uint8_t bucket = 0;
+  while (latency && bucket < DS3231_INSTR_BUCKETS - 1) {
+    latency >>= 1;
+    bucket++;
+  }
+  m.calls++;
+  if (m.latency[bucket] != UINT16_MAX)
+    m.latency[bucket]++;
+  _method = DS3231_METHOD_OTHER;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Count an I2C transaction for the current method and trace it
+  @param  reg first register
+  @param  wlen bytes written, the register address included
+  @param  rlen bytes read, 0 for a write
+  @param  result 0 or a DS3231_ERROR_t code
+  @param  start micros() at the start of the transaction
+  @param  latency micros spent, lock and retries included
+*/
+/**************************************************************************/
+void DS3231Instrumentation::transaction(uint8_t reg, uint8_t wlen, uint8_t rlen, uint8_t result, uint32_t start, uint32_t latency) {
+  DS3231MethodStats_t &m = _methods[_method];
+  m.bytes += wlen + rlen;
+  if (result && m.errors != UINT16_MAX)
+    m.errors++;
+
+  DS3231Trace_t &t = _trace[_head];
+  t.time = start;
+  t.latency = (latency > UINT16_MAX) ? UINT16_MAX : latency;
+  t.reg = reg;
+  t.len = rlen ? (rlen | DS3231_TRACE_READ) : wlen - 1;
+  t.result = result;
+  t.method = _method;
+  _head = (_head + 1) % DS3231_TRACE_SIZE;
+  if (_traced < DS3231_TRACE_SIZE)
+    _traced++;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Entry of the trace
+  @param  i 0 for the oldest to traced() - 1 for the latest
+*/
+/**************************************************************************/
+const DS3231Trace_t& DS3231Instrumentation::trace(uint8_t i) const {
+  return _trace[(_head + DS3231_TRACE_SIZE - _traced + i) % DS3231_TRACE_SIZE];
+}
+
+/**************************************************************************/
+/*!
+  @brief  Clear the counters and the trace
+*/
+/**************************************************************************/
+void DS3231Instrumentation::reset(void) {
+  memset(_methods, 0, sizeof(_methods));
+  _head = 0;
+  _traced = 0;
+}
+
+// Copies the bytes of the dump that fall in the window [offset, offset + size)
+class DS3231DumpWriter
+{
+public:
+  DS3231DumpWriter(uint8_t *buf, uint16_t size, uint16_t offset) : _buf(buf), _size(size), _offset(offset) {}
+
+  void put(uint8_t val) {
+    if (_buf && _pos >= _offset && _pos - _offset < _size)
+      _buf[_pos - _offset] = val;
+    _pos++;
+  }
+  void put16(uint16_t val) { put(val); put(val >> 8); }
+  void put32(uint32_t val) { put16(val); put16(val >> 16); }
+  uint16_t pos(void) const { return _pos; }
+
+private:
+  uint8_t *_buf;
+  uint16_t _size;
+  uint16_t _offset;
+  uint16_t _pos{0};
+};
+
+static void writeDump(DS3231DumpWriter &w, const DS3231Instrumentation &instr) {
+  uint8_t used = 0;
+  for (uint8_t id = 0; id < DS3231_METHODS; id++) {
+    const DS3231MethodStats_t &m = instr.method(static_cast<DS3231_METHOD_t>(id));
+    if (m.calls || m.bytes)
+      used++;
+  }
+
+  // header, little endian
+  w.put('D');
+  w.put('3');
+  w.put('I');
+  w.put(DS3231_DUMP_VERSION);
+  w.put(used);
+  w.put(DS3231_INSTR_BUCKETS);
+  w.put(instr.traced());
+  w.put(0);
+
+  for (uint8_t id = 0; id < DS3231_METHODS; id++) {
+    const DS3231MethodStats_t &m = instr.method(static_cast<DS3231_METHOD_t>(id));
+    if (!m.calls && !m.bytes)
+      continue;
+    w.put(id);
+    w.put32(m.calls);
+    w.put32(m.bytes);
+    w.put16(m.errors);
+    for (uint8_t b = 0; b < DS3231_INSTR_BUCKETS; b++)
+      w.put16(m.latency[b]);
+  }
+
+  for (uint8_t i = 0; i < instr.traced(); i++) {
+    const DS3231Trace_t &t = instr.trace(i);
+    w.put32(t.time);
+    w.put16(t.latency);
+    w.put(t.reg);
+    w.put(t.len);
+    w.put(t.result);
+    w.put(t.method);
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  Size of the binary dump of the counters and the trace
+*/
+/**************************************************************************/
+uint16_t DS3231Instrumentation::dumpSize(void) const {
+  DS3231DumpWriter w(nullptr, 0, 0);
+  writeDump(w, *this);
+  return w.pos();
+}
+
+/**************************************************************************/
+/*!
+  @brief  Binary dump of the counters and the trace, for a serial port
+  @param  buf buffer for the dump
+  @param  size size of the buffer
+  @param  offset position in the dump of the first byte to copy
+  @return Number of bytes copied, 0 past the end of the dump
+  @details The dump can be copied in chunks of any size by increasing the
+  offset, do not call the DS3231 methods in between. The format is decoded
+  by extras/instrumentation/decode_dump.py.
+*/
+/**************************************************************************/
+uint16_t DS3231Instrumentation::dump(uint8_t *buf, uint16_t size, uint16_t offset) const {
+  DS3231DumpWriter w(buf, size, offset);
+  writeDump(w, *this);
+  if (w.pos() <= offset)
+    return 0;
+  return (w.pos() - offset < size) ? w.pos() - offset : size;
+}
+#endif
@@ -0,0 +1,112 @@
+#ifndef __DS3231_INSTRUMENTATION_H__
+#define __DS3231_INSTRUMENTATION_H__
+// Opt-in counters, latency histograms and transaction trace of the DS3231
+// driver. Compiled only when DS3231_INSTRUMENTATION is defined for the whole
+// build (e.g. build_flags = -DDS3231_INSTRUMENTATION), the library then
+// counts every public method of DS3231 and every I2C transaction. Without
+// it, the driver has no instrumentation code nor data and
+// DS3231::instrumentation() does not exist.
+#include <Arduino.h>
+
+#ifndef DS3231_INSTR_BUCKETS
+#define DS3231_INSTR_BUCKETS  16    // log2 latency buckets per method
+#endif
+#ifndef DS3231_TRACE_SIZE
+#define DS3231_TRACE_SIZE     16    // transactions kept in the trace ring buffer
+#endif
+#define DS3231_TRACE_READ     0x80  // or-ed with the length of a read in DS3231Trace_t
+#define DS3231_DUMP_VERSION   1     // of the dump() format, see extras/instrumentation
+
+// Public methods of DS3231, in the order of the dump (keep the names of
+// extras/instrumentation/decode_dump.py in sync)
+typedef enum {
+  DS3231_METHOD_OTHER,              /* transactions outside of a method */
+  DS3231_METHOD_BEGIN,
+  DS3231_METHOD_LOST_POWER,
+  DS3231_METHOD_ADJUST,
+  DS3231_METHOD_ADJUST_ALIGNED,
+  DS3231_METHOD_NOW,
+  DS3231_METHOD_EPOCH_NOW,
+  DS3231_METHOD_SNAPSHOT,
+  DS3231_METHOD_READ_SQW,
+  DS3231_METHOD_SET_SQW,
+  DS3231_METHOD_GET_TEMPERATURE,
+  DS3231_METHOD_GET_TEMPERATURE_RAW,
+  DS3231_METHOD_START_CONVERSION,
+  DS3231_METHOD_IS_CONVERTING,
+  DS3231_METHOD_GET_AGING_OFFSET,
+  DS3231_METHOD_SET_AGING_OFFSET,
+  DS3231_METHOD_SET_ALARM1,
+  DS3231_METHOD_SET_ALARM2,
+  DS3231_METHOD_GET_ALARM1_STATUS,
+  DS3231_METHOD_GET_ALARM2_STATUS,
+  DS3231_METHOD_IS_ALARM_ARMED,
+  DS3231_METHOD_CLEAR_ALARM,
+  DS3231_METHOD_DISABLE_ALARM,
+  DS3231_METHOD_ALARM_FIRED,
+  DS3231_METHOD_SERVICE,
+  DS3231_METHOD_ENABLE_32K,
+  DS3231_METHOD_DISABLE_32K,
+  DS3231_METHOD_IS_32K_ENABLED,
+  DS3231_METHOD_ENABLE_BBSQW,
+  DS3231_METHOD_DISABLE_BBSQW,
+  DS3231_METHOD_ENABLE_SHADOW,
+  DS3231_METHOD_RESYNC,
+  DS3231_METHOD_COMMIT,
+  DS3231_METHODS                    /* number of methods */
+} DS3231_METHOD_t;
+
+// Counters of a method, the transactions of the methods it calls included
+typedef struct {
+  uint32_t calls;
+  uint32_t bytes;       // on the wire, excluding the address bytes
+  uint16_t errors;      // failed transactions
+  uint16_t latency[DS3231_INSTR_BUCKETS];  // calls taking 2^(n-1) to 2^n - 1 micros in bucket n, the last one open-ended
+} DS3231MethodStats_t;
+
+// One I2C transaction
+typedef struct {
+  uint32_t time;        // micros() at the start
+  uint16_t latency;     // micros, 65535 for longer
+  uint8_t reg;          // first register
+  uint8_t len;          // bytes written after the register address, or bytes read | DS3231_TRACE_READ
+  uint8_t result;       // DS3231_ERROR_t
+  uint8_t method;       // DS3231_METHOD_t
+} DS3231Trace_t;
+
+class DS3231Instrumentation
+{
+public:
+  const DS3231MethodStats_t& method(DS3231_METHOD_t id) const { return _methods[id]; }
+  uint8_t traced(void) const { return _traced; }
+  const DS3231Trace_t& trace(uint8_t i) const;
+  void reset(void);
+  uint16_t dumpSize(void) const;
+  uint16_t dump(uint8_t *buf, uint16_t size, uint16_t offset = 0) const;
+
+  bool enter(uint8_t method);
+  void leave(uint32_t latency);
+  void transaction(uint8_t reg, uint8_t wlen, uint8_t rlen, uint8_t result, uint32_t start, uint32_t latency);
+
+private:
+  DS3231MethodStats_t _methods[DS3231_METHODS]{};
+  DS3231Trace_t _trace[DS3231_TRACE_SIZE]{};
+  uint8_t _head{0};     // next entry of the trace
+  uint8_t _traced{0};   // entries in the trace
+  uint8_t _method{DS3231_METHOD_OTHER};  // method being counted
+};
+
+// Counts a call from its construction to the end of the scope, a method
+// called by another one is counted as part of the outer call only
+class DS3231Probe
+{
+public:
+  DS3231Probe(DS3231Instrumentation *instr, uint8_t method)
+    : _instr(instr->enter(method) ? instr : nullptr), _start(micros()) {}
+  ~DS3231Probe() { if (_instr) _instr->leave(micros() - _start); }
+
+private:
+  DS3231Instrumentation *_instr;
+  uint32_t _start;
+};
+#endif
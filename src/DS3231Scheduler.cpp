@@ -0,0 +1,210 @@
+#include "DS3231Scheduler.h"
+
+
+DS3231SchedulerBase::DS3231SchedulerBase(DS3231Alarm_t *pool, uint8_t *heap, uint8_t capacity)
+  : _pool(pool), _heap(heap), _capacity(capacity) {
+}
+
+/**************************************************************************/
+/*!
+  @brief  Start the scheduler with all the alarms free
+  @param  rtc pointer to a DS3231 object that has been begin()
+  @details Both hardware alarms are used by the scheduler, and the INT/SQW
+  pin is switched to interrupt mode when an alarm is programmed.
+*/
+/**************************************************************************/
+void DS3231SchedulerBase::begin(DS3231 *rtc) {
+  _rtc = rtc;
+  _count = 0;
+  _armed = 0;
+  _servicing = false;
+  for (uint8_t i = 0; i < _capacity; i++) {
+    _pool[i].pos = DS3231_SCHEDULER_NONE;
+    _heap[i] = i;
+  }
+}
+
+/**************************************************************************/
+/*!
+  @brief  Schedule a one-shot alarm
+  @param  epoch due time in seconds since 2000/01/01 00:00:00
+  @param  task function to be called by service() when the alarm is due
+  @return alarm id, or -1 if the pool is full
+*/
+/**************************************************************************/
+int8_t DS3231SchedulerBase::at(uint32_t epoch, DS3231Task_t task) {
+  return _insert(epoch, 0, task);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Schedule a recurring alarm
+  @param  period interval in seconds
+  @param  task function to be called by service() when the alarm is due
+  @param  offset the alarm is due when (seconds since 2000) % period equals
+  offset, e.g. every(3600, task, 300) fires at 5 minutes past every hour
+  @return alarm id, or -1 if the pool is full
+*/
+/**************************************************************************/
+int8_t DS3231SchedulerBase::every(uint32_t period, DS3231Task_t task, uint32_t offset) {
+  if (period == 0)
+    return -1;
+  uint32_t now = _rtc->epochNow();
+  uint32_t due = now - (now % period) + (offset % period);
+  if (due <= now)
+    due += period;
+  return _insert(due, period, task);
+}
+
+/**************************************************************************/
+/*!
+  @brief  Cancel an alarm
+  @param  id alarm id
+  @return True if the alarm was scheduled
+*/
+/**************************************************************************/
+bool DS3231SchedulerBase::cancel(uint8_t id) {
+  if (id >= _capacity || _pool[id].pos == DS3231_SCHEDULER_NONE)
+    return false;
+  uint8_t pos = _pool[id].pos;
+  _remove(pos);
+  if (pos == 0 && !_servicing)
+    _arm();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Dispatch the alarms that are due and program the next one
+  @return number of tasks called
+  @details Call it when the INT pin is asserted (or periodically). Recurring
+  alarms are rescheduled, skipping the periods that were missed. The
+  hardware alarm is only re-programmed when the next due alarm changes.
+*/
+/**************************************************************************/
+uint8_t DS3231SchedulerBase::service(void) {
+  uint8_t dispatched = 0;
+  _servicing = true;
+  if (_armed)
+    _rtc->clearAlarm(_armed);
+
+  do {
+    uint32_t now = _rtc->epochNow();
+    while (_count && _pool[_heap[0]].due <= now) {
+      uint8_t id = _heap[0];
+      DS3231Alarm_t &alarm = _pool[id];
+      DS3231Task_t task = alarm.task;
+      if (alarm.period) {
+        alarm.due += ((now - alarm.due) / alarm.period + 1) * alarm.period;
+        _down(0);
+      }
+      else {
+        _remove(0);
+      }
+      task(id);
+      dispatched++;
+    }
+  } while (!_arm());  // the next alarm became due while it was programmed
+
+  _servicing = false;
+  return dispatched;
+}
+
+int8_t DS3231SchedulerBase::_insert(uint32_t due, uint32_t period, DS3231Task_t task) {
+  if (_count == _capacity)
+    return -1;
+  uint8_t id = _heap[_count];  // the ids past the end of the heap are the free ones
+
+  _pool[id].due = due;
+  _pool[id].period = period;
+  _pool[id].task = task;
+  _pool[id].pos = _count;
+  _up(_count++);
+
+  if (_pool[id].pos == 0 && !_servicing)
+    _arm();
+  return id;
+}
+
+// The removed id is swapped to the end of the heap, where _insert() takes
+// the free ids from
+void DS3231SchedulerBase::_remove(uint8_t pos) {
+  uint8_t id = _heap[pos];
+  uint8_t last = --_count;
+  if (pos != last) {
+    _swap(pos, last);
+    _down(pos);
+    _up(pos);
+  }
+  _pool[id].pos = DS3231_SCHEDULER_NONE;
+}
+
+void DS3231SchedulerBase::_up(uint8_t pos) {
+  while (pos > 0) {
+    uint8_t parent = (pos - 1) / 2;
+    if (_pool[_heap[parent]].due <= _pool[_heap[pos]].due)
+      break;
+    _swap(pos, parent);
+    pos = parent;
+  }
+}
+
+void DS3231SchedulerBase::_down(uint8_t pos) {
+  for (;;) {
+    uint8_t smallest = pos;
+    uint8_t left = 2 * pos + 1;
+    uint8_t right = left + 1;
+    if (left < _count && _pool[_heap[left]].due < _pool[_heap[smallest]].due)
+      smallest = left;
+    if (right < _count && _pool[_heap[right]].due < _pool[_heap[smallest]].due)
+      smallest = right;
+    if (smallest == pos)
+      return;
+    _swap(pos, smallest);
+    pos = smallest;
+  }
+}
+
+void DS3231SchedulerBase::_swap(uint8_t a, uint8_t b) {
+  uint8_t id = _heap[a];
+  _heap[a] = _heap[b];
+  _heap[b] = id;
+  _pool[_heap[a]].pos = a;
+  _pool[_heap[b]].pos = b;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Program the next due alarm into the DS3231
+  @return False if the alarm was already due when it was programmed
+  @details Minute aligned alarms use Alarm 2, the others Alarm 1. Nothing
+  is written when the next due alarm is the one already programmed.
+*/
+/**************************************************************************/
+bool DS3231SchedulerBase::_arm(void) {
+  if (_count == 0) {
+    if (_armed)
+      _rtc->disableAlarm(_armed);
+    _armed = 0;
+    return true;
+  }
+
+  uint32_t due = _pool[_heap[0]].due;
+  if (_armed && due == _armed_due)
+    return true;
+
+  DateTime dt{};
+  DS3231::fromEpoch(due, &dt);
+  uint8_t alarm_num = (dt.tm_sec == 0) ? 2 : 1;
+  if (_armed && _armed != alarm_num)
+    _rtc->disableAlarm(_armed);
+
+  if (alarm_num == 2)
+    _rtc->setAlarm2(&dt, DS3231_ALARM2_ON_DATE);
+  else
+    _rtc->setAlarm1(&dt, DS3231_ALARM1_ON_DATE);
+  _armed = alarm_num;
+  _armed_due = due;
+
+  return _rtc->epochNow() < due;
+}
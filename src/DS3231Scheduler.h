@@ -0,0 +1,64 @@
+#ifndef __DS3231_SCHEDULER_H__
+#define __DS3231_SCHEDULER_H__
+#include "DS3231.h"
+
+#define DS3231_SCHEDULER_NONE 0xFF
+
+// Called when a scheduled alarm is due, id as returned by at() or every()
+typedef void (*DS3231Task_t)(uint8_t id);
+
+typedef struct {
+  uint32_t due;       // seconds since 2000/01/01 00:00:00
+  uint32_t period;    // 0 for a one-shot alarm
+  DS3231Task_t task;
+  uint8_t pos;        // position in the heap, DS3231_SCHEDULER_NONE when free
+} DS3231Alarm_t;
+
+// Any number of logical alarms multiplexed on the two hardware alarms, only
+// the next due alarm is programmed into the DS3231. Use DS3231Scheduler<N>
+// for a pool of N alarms.
+class DS3231SchedulerBase
+{
+public:
+  void begin(DS3231 *rtc);
+  int8_t at(uint32_t epoch, DS3231Task_t task);
+  int8_t every(uint32_t period, DS3231Task_t task, uint32_t offset = 0);
+  bool cancel(uint8_t id);
+  uint8_t service(void);
+  uint32_t next(void) const { return _count ? _pool[_heap[0]].due : 0; }
+  uint8_t count(void) const { return _count; }
+
+protected:
+  DS3231SchedulerBase(DS3231Alarm_t *pool, uint8_t *heap, uint8_t capacity);
+
+private:
+  DS3231 *_rtc{nullptr};
+  DS3231Alarm_t *_pool;
+  uint8_t *_heap;              // ids of the alarms by due time, then the free ids
+  uint8_t _capacity;
+  uint8_t _count{0};
+  uint8_t _armed{0};           // hardware alarm in use, 0 for none
+  uint32_t _armed_due{0};
+  bool _servicing{false};
+
+  int8_t _insert(uint32_t due, uint32_t period, DS3231Task_t task);
+  void _remove(uint8_t pos);
+  void _up(uint8_t pos);
+  void _down(uint8_t pos);
+  void _swap(uint8_t a, uint8_t b);
+  bool _arm(void);
+};
+
+template <uint8_t N>
+class DS3231Scheduler : public DS3231SchedulerBase
+{
+  static_assert(N <= 127, "at() and every() return the alarm id as an int8_t, at most 127 alarms");
+
+public:
+  DS3231Scheduler() : DS3231SchedulerBase(_alarms, _order, N) {}
+
+private:
+  DS3231Alarm_t _alarms[N];
+  uint8_t _order[N];
+};
+#endif
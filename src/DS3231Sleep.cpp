@@ -0,0 +1,127 @@
+#include "DS3231Sleep.h"
+
+/**************************************************************************/
+/*!
+  @brief  Start managing the alarms for the sleep of the MCU
+  @param  rtc pointer to a DS3231 object that has been begin()
+  @param  options DS3231_SLEEP_BATTERY and/or DS3231_SLEEP_RESTORE
+  @details The alarms are used exclusively, do not use setAlarm1(),
+  setAlarm2() or a DS3231Scheduler on the same DS3231.
+*/
+/**************************************************************************/
+void DS3231Sleep::begin(DS3231 *rtc, uint8_t options) {
+  _rtc = rtc;
+  _options = options;
+  _armed = 0;
+  _due = 0;
+  _woken = false;
+  _stats = DS3231SleepStats_t{};
+  if (options & DS3231_SLEEP_BATTERY)
+    _rtc->enableBBSQW();
+}
+
+/**************************************************************************/
+/*!
+  @brief  Arm the alarm that wakes the MCU at a given time
+  @param  epoch seconds since 2000/01/01 00:00:00
+  @return False if the time has already passed when the alarm was armed,
+  do not go to sleep
+  @details The alarm, its flag and the outputs are written in a single
+  transaction with the shadow registers enabled, and the time is read once
+  to check that the alarm is still ahead.
+*/
+/**************************************************************************/
+bool DS3231Sleep::sleepUntil(uint32_t epoch) {
+  uint32_t since = _rtc->busStats().transactions;
+  bool armed = _arm(epoch);
+  _count(since);
+  return armed;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Arm the alarm that wakes the MCU after a number of seconds
+  @param  seconds seconds to sleep
+  @return False if the time has already passed when the alarm was armed,
+  do not go to sleep
+  @details After a wake() at the due time, the seconds are counted from
+  that due time instead of the current time, so a periodic wakeup does not
+  drift and the time is not read. If that time has already passed, the
+  next call counts from the current time.
+*/
+/**************************************************************************/
+bool DS3231Sleep::sleepFor(uint32_t seconds) {
+  uint32_t since = _rtc->busStats().transactions;
+  uint32_t from = _woken ? _due : _rtc->epochNow();
+  bool armed = _arm(from + seconds);
+  _count(since);
+  return armed;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Check the alarm after the MCU woke up
+  @return True when the due time is reached, false when the MCU woke up
+  early and should go back to sleep, the alarm stays armed
+  @details The alarm matches the day of the month, so a wakeup more than 28
+  days ahead may match a month early. The alarm is disabled at the due
+  time and, with DS3231_SLEEP_RESTORE, the 32kHz and SQW outputs are
+  restored in the same write.
+*/
+/**************************************************************************/
+bool DS3231Sleep::wake(void) {
+  if (!_armed)
+    return true;
+
+  uint32_t since = _rtc->busStats().transactions;
+  _stats.wakeups++;
+  DS3231Snapshot snap = _rtc->snapshot();
+  if (DS3231::toEpoch(snap.now()) < _due) {
+    if (snap.alarmFired(_armed))
+      _rtc->clearAlarm(_armed);
+    _stats.early++;
+    _count(since);
+    return false;
+  }
+
+  _rtc->beginTransaction();
+  _rtc->disableAlarm(_armed);
+  if (_options & DS3231_SLEEP_RESTORE) {
+    if (_en32k)
+      _rtc->enable32K();
+    if (_sqw != DS3231_SQW_OFF)
+      _rtc->setSquareWaveRate(_sqw);
+  }
+  _rtc->commit();
+  _armed = 0;
+  _woken = true;
+  _count(since);
+  return true;
+}
+
+bool DS3231Sleep::_arm(uint32_t epoch) {
+  DateTime dt{};
+  DS3231::fromEpoch(epoch, &dt);
+  uint8_t alarm_num = (dt.tm_sec == 0) ? 2 : 1;
+
+  _rtc->beginTransaction();
+  if (!_armed && (_options & DS3231_SLEEP_RESTORE)) {
+    _sqw = _rtc->readSquareWaveRate();
+    _en32k = _rtc->is32KEnabled();
+  }
+  if (_armed && _armed != alarm_num)
+    _rtc->disableAlarm(_armed);
+  if (alarm_num == 2)
+    _rtc->setAlarm2(&dt, DS3231_ALARM2_ON_DATE);
+  else
+    _rtc->setAlarm1(&dt, DS3231_ALARM1_ON_DATE);
+  _rtc->clearAlarm(alarm_num);
+  _rtc->disable32K();
+  _rtc->commit();
+
+  _armed = alarm_num;
+  _due = epoch;
+  _woken = false;
+  _stats.sleeps++;
+  return _rtc->epochNow() < epoch;
+}
@@ -0,0 +1,46 @@
+#ifndef __DS3231_SLEEP_H__
+#define __DS3231_SLEEP_H__
+#include "DS3231.h"
+
+#define DS3231_SLEEP_BATTERY  0x01  // BBSQW: the alarm asserts INT on battery power too
+#define DS3231_SLEEP_RESTORE  0x02  // restore the 32kHz and SQW outputs on wake()
+
+// Counters for the power budget of a sleeping application
+typedef struct {
+  uint32_t sleeps;        // alarms armed by sleepUntil() / sleepFor()
+  uint32_t wakeups;       // wake() calls, including the early ones
+  uint32_t early;         // wakeups before the due time, the MCU went back to sleep
+  uint32_t transactions;  // I2C transactions of sleepUntil(), sleepFor() and wake()
+} DS3231SleepStats_t;
+
+// Puts the DS3231 in charge of waking the MCU with a single alarm. The
+// alarm is the coarsest one that is correct: Alarm 2 (minutes) when the
+// wakeup is minute aligned, Alarm 1 (seconds) otherwise. The 32kHz output
+// is switched off while sleeping and SQW is off as INTCN is set. Enable the
+// shadow registers for a single write per sleep.
+class DS3231Sleep
+{
+public:
+  void begin(DS3231 *rtc, uint8_t options = 0);
+  bool sleepUntil(uint32_t epoch);
+  bool sleepFor(uint32_t seconds);
+  bool wake(void);
+  uint32_t due(void) const { return _due; }
+  uint8_t alarm(void) const { return _armed; }
+  const DS3231SleepStats_t& stats(void) const { return _stats; }
+  void resetStats(void) { _stats = DS3231SleepStats_t{}; }
+
+private:
+  DS3231 *_rtc{nullptr};
+  uint8_t _options{0};
+  uint8_t _armed{0};        // hardware alarm in use, 0 for none
+  uint32_t _due{0};
+  bool _woken{false};       // the last wake() was the due alarm
+  bool _en32k{false};       // outputs to be restored by wake()
+  DS3231_SQW_RATE_t _sqw{DS3231_SQW_OFF};
+  DS3231SleepStats_t _stats{};
+
+  bool _arm(uint32_t epoch);
+  void _count(uint32_t since) { _stats.transactions += _rtc->busStats().transactions - since; }
+};
+#endif
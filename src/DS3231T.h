@@ -0,0 +1,256 @@
+#ifndef __DS3231T_H__
+#define __DS3231T_H__
+#include "DS3231.h"
+
+// Features of DS3231T, a method of a feature that is not selected fails to compile
+typedef enum {
+  DS3231_FEATURE_ALARMS      = 0x01,
+  DS3231_FEATURE_SQW         = 0x02,
+  DS3231_FEATURE_32K         = 0x04,
+  DS3231_FEATURE_TEMPERATURE = 0x08,
+  DS3231_FEATURE_PARSE       = 0x10,
+  DS3231_FEATURE_ALL         = 0x1F
+} DS3231_FEATURE_t;
+
+// Register and bitmask helpers
+constexpr uint8_t ds3231_bit(uint8_t pos) { return static_cast<uint8_t>(1 << pos); }
+constexpr uint8_t ds3231_bin2bcd(uint8_t val) { return static_cast<uint8_t>(val + 6 * (val / 10)); }
+constexpr uint8_t ds3231_bcd2bin(uint8_t val) { return static_cast<uint8_t>(val - 6 * (val >> 4)); }
+constexpr uint8_t ds3231_alarm_enable(uint8_t alarm_num) { return ds3231_bit(alarm_num - 1); }
+constexpr uint8_t ds3231_alarm_flag(uint8_t alarm_num) { return ds3231_bit(alarm_num - 1); }
+constexpr uint8_t ds3231_alarm_arm(uint8_t alarm_num) {
+  return ds3231_bit(DS3231_CONTROL_INTCON) | ds3231_alarm_enable(alarm_num);
+}
+
+/*
+  Compile-time specialised variant of the DS3231 class. The bus type, the
+  I2C address and the selected features are template parameters, so the
+  bus calls can be inlined and only the methods that are used are compiled:
+
+    DS3231T<TwoWire, DS3231_ADDRESS, DS3231_FEATURE_ALARMS> rtc(Wire);
+
+  Not header-only: the date conversions and the DS3231Snapshot decoders are
+  the static members of DS3231 in DS3231.cpp, which must be linked. A read
+  that fails returns the zero registers, as DS3231 does.
+*/
+template <typename Bus, uint8_t Address = DS3231_ADDRESS, uint8_t Features = DS3231_FEATURE_ALL>
+class DS3231T
+{
+public:
+  explicit DS3231T(Bus &bus) : _bus(bus) {}
+
+  bool begin(uint32_t speed = 400000) {
+    _bus.begin();
+    if (speed != 400000L)
+      _bus.setClock(speed);
+    // 32kHz Enable bit is always 1 when power up, read indicated I2C is working
+    return _read(DS3231_STATUS) & ds3231_bit(DS3231_STATUS_EN32KHZ);
+  }
+
+  bool lostPower(void) {
+    return _read(DS3231_STATUS) & ds3231_bit(DS3231_STATUS_OSC_STOP);
+  }
+
+  void adjust(const DateTime &dt) {
+    DateTime chip = dt;
+    DS3231::_to_chip(&chip);
+    uint8_t buffer[] = {
+      DS3231_TIME,
+      ds3231_bin2bcd(chip.tm_sec),
+      ds3231_bin2bcd(chip.tm_min),
+      ds3231_bin2bcd(chip.tm_hour),
+      ds3231_bin2bcd(chip.tm_wday + 1),
+      ds3231_bin2bcd(chip.tm_mday),
+      static_cast<uint8_t>(ds3231_bin2bcd(chip.tm_mon) | ((chip.tm_year >= 100) ? 0x80 : 0)),
+      ds3231_bin2bcd(chip.tm_year % 100)
+    };
+    _write(buffer, sizeof(buffer));
+    _update(DS3231_STATUS, ds3231_bit(DS3231_STATUS_OSC_STOP), 0);
+  }
+
+  DateTime now() {
+    DS3231Snapshot snap{};
+    _read(DS3231_TIME, snap.reg, 7);
+    return snap.now();
+  }
+
+  uint32_t epochNow() {
+    DateTime dt = now();
+    return DS3231::toEpoch(dt);
+  }
+
+  DS3231Snapshot snapshot() {
+    DS3231Snapshot snap{};
+    _read(DS3231_TIME, snap.reg, sizeof(snap.reg));
+    return snap;
+  }
+
+  // DS3231_FEATURE_SQW
+
+  DS3231_SQW_RATE_t readSquareWaveRate() {
+    static_assert(Features & DS3231_FEATURE_SQW, "DS3231_FEATURE_SQW is not selected");
+    return static_cast<DS3231_SQW_RATE_t>(_read(DS3231_CONTROL) & DS3231_SQW_OFF);
+  }
+
+  void setSquareWaveRate(DS3231_SQW_RATE_t rate) {
+    static_assert(Features & DS3231_FEATURE_SQW, "DS3231_FEATURE_SQW is not selected");
+    _update(DS3231_CONTROL, DS3231_SQW_OFF, rate);
+  }
+
+  // DS3231_FEATURE_TEMPERATURE
+
+  float getTemperature() {
+    static_assert(Features & DS3231_FEATURE_TEMPERATURE, "DS3231_FEATURE_TEMPERATURE is not selected");
+    DS3231Snapshot snap{};
+    _read(DS3231_TEMPERATURE, &snap.reg[DS3231_TEMPERATURE], 2);
+    return snap.temperature();
+  }
+
+  int16_t getTemperatureRaw() {
+    static_assert(Features & DS3231_FEATURE_TEMPERATURE, "DS3231_FEATURE_TEMPERATURE is not selected");
+    DS3231Snapshot snap{};
+    _read(DS3231_TEMPERATURE, &snap.reg[DS3231_TEMPERATURE], 2);
+    return snap.temperatureRaw();
+  }
+
+  // DS3231_FEATURE_ALARMS
+
+  void setAlarm1(const DateTime *dt, DS3231_ALARM1_t alarm_mode) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    bool dy = alarm_mode & 0x10;
+    uint8_t day = dy ? DS3231::weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday) + 1 : DS3231::_chip_date(dt);
+    uint8_t buffer[] = {
+      DS3231_ALARM1,
+      static_cast<uint8_t>(ds3231_bin2bcd(dt->tm_sec) | ((alarm_mode & 0x01) << 7)),
+      static_cast<uint8_t>(ds3231_bin2bcd(dt->tm_min) | ((alarm_mode & 0x02) << 6)),
+      static_cast<uint8_t>(ds3231_bin2bcd(dt->tm_hour) | ((alarm_mode & 0x04) << 5)),
+      static_cast<uint8_t>(ds3231_bin2bcd(day) | ((alarm_mode & 0x08) << 4) | (dy ? 0x40 : 0))
+    };
+    _write(buffer, sizeof(buffer));
+    _update(DS3231_CONTROL, ds3231_alarm_arm(1), ds3231_alarm_arm(1));
+  }
+
+  void setAlarm2(const DateTime *dt, DS3231_ALARM2_t alarm_mode) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    bool dy = alarm_mode & 0x08;
+    uint8_t day = dy ? DS3231::weekDay(dt->tm_year, dt->tm_mon, dt->tm_mday) + 1 : DS3231::_chip_date(dt);
+    uint8_t buffer[] = {
+      DS3231_ALARM2,
+      static_cast<uint8_t>(ds3231_bin2bcd(dt->tm_min) | ((alarm_mode & 0x01) << 7)),
+      static_cast<uint8_t>(ds3231_bin2bcd(dt->tm_hour) | ((alarm_mode & 0x02) << 6)),
+      static_cast<uint8_t>(ds3231_bin2bcd(day) | ((alarm_mode & 0x04) << 5) | (dy ? 0x40 : 0))
+    };
+    _write(buffer, sizeof(buffer));
+    _update(DS3231_CONTROL, ds3231_alarm_arm(2), ds3231_alarm_arm(2));
+  }
+
+  DS3231_ALARM1_t getAlarm1Status(DateTime *dt) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    DS3231Snapshot snap{};
+    // the month and year registers date the alarm
+    _read(DS3231_TIME + 5, &snap.reg[DS3231_TIME + 5], 2 + 4);
+    return snap.alarm1(dt);
+  }
+
+  DS3231_ALARM2_t getAlarm2Status(DateTime *dt) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    DS3231Snapshot snap{};
+    _read(DS3231_TIME + 5, &snap.reg[DS3231_TIME + 5], 2 + 4 + 3);
+    return snap.alarm2(dt);
+  }
+
+  bool isAlarmArmed(uint8_t alarm_num) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    return _read(DS3231_CONTROL) & ds3231_alarm_enable(alarm_num);
+  }
+
+  void clearAlarm(uint8_t alarm_num) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    _update(DS3231_STATUS, ds3231_alarm_flag(alarm_num), 0);
+  }
+
+  void disableAlarm(uint8_t alarm_num) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    _update(DS3231_CONTROL, ds3231_alarm_enable(alarm_num), 0);
+    clearAlarm(alarm_num);
+  }
+
+  bool alarmFired(uint8_t alarm_num) {
+    static_assert(Features & DS3231_FEATURE_ALARMS, "DS3231_FEATURE_ALARMS is not selected");
+    return _read(DS3231_STATUS) & ds3231_alarm_flag(alarm_num);
+  }
+
+  // DS3231_FEATURE_32K
+
+  void enable32K(void) {
+    static_assert(Features & DS3231_FEATURE_32K, "DS3231_FEATURE_32K is not selected");
+    _update(DS3231_STATUS, ds3231_bit(DS3231_STATUS_EN32KHZ), ds3231_bit(DS3231_STATUS_EN32KHZ));
+  }
+
+  void disable32K(void) {
+    static_assert(Features & DS3231_FEATURE_32K, "DS3231_FEATURE_32K is not selected");
+    _update(DS3231_STATUS, ds3231_bit(DS3231_STATUS_EN32KHZ), 0);
+  }
+
+  bool is32KEnabled(void) {
+    static_assert(Features & DS3231_FEATURE_32K, "DS3231_FEATURE_32K is not selected");
+    return _read(DS3231_STATUS) & ds3231_bit(DS3231_STATUS_EN32KHZ);
+  }
+
+  // DS3231_FEATURE_PARSE
+
+  static void getDateTime(const char* d, const char* t, DateTime* dt) {
+    static_assert(Features & DS3231_FEATURE_PARSE, "DS3231_FEATURE_PARSE is not selected");
+    DS3231::getDateTime(d, t, dt);
+  }
+
+  static bool getDateTime(const char* ts, DateTime* dt) {
+    static_assert(Features & DS3231_FEATURE_PARSE, "DS3231_FEATURE_PARSE is not selected");
+    return DS3231::getDateTime(ts, dt);
+  }
+
+  static bool parse(const char *s, size_t len, DateTime *dt) {
+    static_assert(Features & DS3231_FEATURE_PARSE, "DS3231_FEATURE_PARSE is not selected");
+    return DS3231::parse(s, len, dt);
+  }
+
+  static uint8_t format(char *buf, size_t size, const DateTime &dt, DS3231_FORMAT_t fmt = DS3231_FORMAT_ISO8601) {
+    static_assert(Features & DS3231_FEATURE_PARSE, "DS3231_FEATURE_PARSE is not selected");
+    return DS3231::format(buf, size, dt, fmt);
+  }
+
+private:
+  Bus &_bus;
+
+  void _write(const uint8_t *buf, uint8_t len) {
+    _bus.beginTransmission(Address);
+    _bus.write(buf, len);
+    _bus.endTransmission();
+  }
+
+  // the STATUS flags outside the mask are written as 1 (unchanged), so a
+  // flag set between the read and the write is kept
+  void _update(uint8_t reg, uint8_t mask, uint8_t bits) {
+    uint8_t keep = (reg == DS3231_STATUS) ? (DS3231_STATUS_FLAGS & ~mask) : 0;
+    uint8_t buffer[] = {reg, static_cast<uint8_t>((_read(reg) & ~mask) | bits | keep)};
+    _write(buffer, sizeof(buffer));
+  }
+
+  uint8_t _read(uint8_t reg) {
+    uint8_t data{0};
+    _read(reg, &data, 1);
+    return data;
+  }
+
+  void _read(uint8_t reg, uint8_t *data, uint8_t len) {
+    _bus.beginTransmission(Address);
+    _bus.write(reg);
+    _bus.endTransmission(false);
+
+    uint8_t i = 0;
+    _bus.requestFrom(Address, len);
+    while (_bus.available() && i < len)
+      data[i++] = _bus.read();
+  }
+};
+#endif
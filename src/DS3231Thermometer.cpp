@@ -0,0 +1,167 @@
+#include "DS3231Thermometer.h"
+
+
+/**************************************************************************/
+/*!
+  @brief  Start the thermometer with an empty history
+  @param  rtc pointer to a DS3231 object that has been begin()
+*/
+/**************************************************************************/
+void DS3231Thermometer::begin(DS3231 *rtc) {
+  _rtc = rtc;
+  _head = 0;
+  _count = 0;
+  _converting = false;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Take a new sample when the DS3231 has a new temperature
+  @return True when a new sample has been added to the history
+  @details Never waits: while a conversion is in progress each call costs
+  one I2C transaction, otherwise nothing is read until the next automatic
+  conversion is due. The cache follows the conversions of the DS3231, a
+  read that finds BSY set waits for the conversion in progress.
+*/
+/**************************************************************************/
+bool DS3231Thermometer::update(void) {
+  if (_converting) {
+    if (_rtc->isConverting())
+      return false;
+    _converting = false;
+    return _sample();
+  }
+  if (_count && millis() - _time[_head] < DS3231_THERMOMETER_PERIOD)
+    return false;
+  return _sample();
+}
+
+/**************************************************************************/
+/*!
+  @brief  Force a temperature conversion, e.g. after a change of the supply
+  @return False if the DS3231 is busy with an automatic conversion
+  @details The new sample is taken by update() when the conversion has
+  completed.
+*/
+/**************************************************************************/
+bool DS3231Thermometer::convert(void) {
+  if (_converting)
+    return true;
+  _converting = _rtc->startConversion();
+  return _converting;
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get the temperature
+  @return temperature in signed Q8.2 fixed point (quarter degrees)
+  @details Same as update() followed by last()
+*/
+/**************************************************************************/
+int16_t DS3231Thermometer::read(void) {
+  update();
+  return last();
+}
+
+/**************************************************************************/
+/*!
+  @brief  Get a sample from the history
+  @param  age 0 for the newest sample, samples() - 1 for the oldest
+  @return temperature in signed Q8.2 fixed point (quarter degrees)
+*/
+/**************************************************************************/
+int16_t DS3231Thermometer::sample(uint8_t age) const {
+  if (age >= _count)
+    return 0;
+  return _history[_index(age)];
+}
+
+/**************************************************************************/
+/*!
+  @brief  Change of temperature over the history
+  @return newest minus oldest sample, in quarter degrees
+*/
+/**************************************************************************/
+int16_t DS3231Thermometer::trend(void) const {
+  if (_count < 2)
+    return 0;
+  return _history[_head] - _history[_index(_count - 1)];
+}
+
+/**************************************************************************/
+/*!
+  @brief  Rate of change of the temperature
+  @return quarter degrees per hour
+  @details Least squares fit of the samples in the history, so a single
+  LSB step of the sensor does not show as a steep rate. The samples do not
+  need to be evenly spaced. The fit is done in 32-bit integers, without
+  floating point code: the time of the samples is counted in steps of a
+  power of two milliseconds, at most DS3231_THERMOMETER_STEPS over the
+  history.
+*/
+/**************************************************************************/
+int16_t DS3231Thermometer::rate(void) const {
+  if (_count < 2)
+    return 0;
+
+  uint32_t origin = _time[_index(_count - 1)];
+  uint32_t span = _time[_head] - origin;
+  uint8_t shift = 0;  // steps of 2^shift milliseconds
+  while ((span >> shift) > DS3231_THERMOMETER_STEPS)
+    shift++;
+
+  int32_t st = 0, sy = 0, stt = 0, sty = 0;
+  for (uint8_t age = 0; age < _count; age++) {
+    uint8_t i = _index(age);
+    int32_t t = (_time[i] - origin) >> shift;
+    st += t;
+    sy += _history[i];
+    stt += t * t;
+    sty += t * _history[i];
+  }
+  int32_t d = _count * stt - st * st;
+  if (d <= 0)
+    return 0;
+  int32_t n = _count * sty - st * sy;  // quarter degrees per step, times d
+
+  // n / d * 3600000 / 2^shift by long division, one factor of 3600000 at
+  // a time so that rest * f stays within 32 bits
+  uint32_t limit = (shift < 17) ? static_cast<uint32_t>(INT16_MAX) << shift : 0xFFFF0000UL;
+  uint32_t x = (n < 0) ? -n : n;
+  uint32_t value = x / d;
+  uint32_t rest = x % d;
+  static const uint8_t factors[] = {15, 15, 25, 5, 16, 8};
+  for (uint8_t f : factors) {
+    if (value > limit / f) {
+      value = limit;  // saturated
+      break;
+    }
+    value = value * f + rest * f / d;
+    rest = rest * f % d;
+  }
+  value >>= shift;
+  if (value > INT16_MAX)
+    value = INT16_MAX;
+  return (n < 0) ? -static_cast<int16_t>(value) : static_cast<int16_t>(value);
+}
+
+bool DS3231Thermometer::_sample(void) {
+  bool busy = false;
+  int16_t value = _rtc->getTemperatureRaw(&busy);
+  if (busy) {
+    _converting = true;  // the registers are about to change
+    return false;
+  }
+
+  if (_count)
+    _head = (_head + 1) % DS3231_THERMOMETER_HISTORY;
+  if (_count < DS3231_THERMOMETER_HISTORY)
+    _count++;
+  _history[_head] = value;
+  _time[_head] = millis();
+  return true;
+}
+
+uint8_t DS3231Thermometer::_index(uint8_t age) const {
+  return (_head + DS3231_THERMOMETER_HISTORY - age) % DS3231_THERMOMETER_HISTORY;
+}
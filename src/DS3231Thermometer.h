@@ -0,0 +1,39 @@
+#ifndef __DS3231_THERMOMETER_H__
+#define __DS3231_THERMOMETER_H__
+#include "DS3231.h"
+
+#define DS3231_THERMOMETER_PERIOD  64000UL  // ms between the automatic conversions of the DS3231
+#define DS3231_THERMOMETER_HISTORY 8        // samples kept for trend() and rate()
+#define DS3231_THERMOMETER_STEPS   1023     // time steps of the history in rate(), its sums fit in 32 bits for 8 samples
+
+// Cached temperature of the DS3231 in signed Q8.2 fixed point (quarter
+// degrees). The registers are only read again after the next automatic
+// conversion, or when a forced conversion has completed, so read() can be
+// called from the loop() without loading the I2C bus.
+class DS3231Thermometer
+{
+public:
+  void begin(DS3231 *rtc);
+  bool update(void);
+  bool convert(void);
+  int16_t read(void);
+  int16_t last(void) const { return _history[_head]; }
+  float celsius(void) const { return last() * 0.25f; }
+  bool isConverting(void) const { return _converting; }
+  uint8_t samples(void) const { return _count; }
+  int16_t sample(uint8_t age) const;
+  int16_t trend(void) const;
+  int16_t rate(void) const;
+
+private:
+  DS3231 *_rtc{nullptr};
+  int16_t _history[DS3231_THERMOMETER_HISTORY]{0};
+  uint32_t _time[DS3231_THERMOMETER_HISTORY]{0};  // millis() of each sample
+  uint8_t _head{0};     // newest sample
+  uint8_t _count{0};
+  bool _converting{false};
+
+  bool _sample(void);
+  uint8_t _index(uint8_t age) const;
+};
+#endif